@@ -0,0 +1,173 @@
+#ifndef TERMFORMAT_ANIMATION_H_
+#define TERMFORMAT_ANIMATION_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <iosfwd>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <termfmt/api.h>
+
+namespace tfmt {
+
+class Modifier;
+class Animation;
+
+/// Counters of an `AnimationScheduler`
+struct AnimationStats {
+    /// Number of frames that were due
+    std::uint64_t frames = 0;
+
+    /// Number of due frames that were identical to the frame of their
+    /// animation on screen, so nothing was written
+    std::uint64_t suppressedFrames = 0;
+
+    /// Number of bytes written to the stream
+    std::uint64_t bytesWritten = 0;
+
+    /// Number of bytes of the suppressed frames
+    std::uint64_t bytesSuppressed = 0;
+};
+
+/// Drives a set of animations from a single timer thread
+/// \details Animations are kept in a hashed timer wheel with one slot per
+/// tick. On every tick the frames of all animations that are due are
+/// concatenated and written to the output stream with a single write
+/// followed by a flush. A frame with the same bytes as the frame its
+/// animation drew last is skipped, and a tick without changed frames writes
+/// nothing. The thread is started with the first animation and sleeps while
+/// no animation is running.
+class TFMT_API AnimationScheduler {
+public:
+    /// Default duration of one tick
+    static constexpr std::chrono::milliseconds DefaultTick{ 10 };
+
+    /// Create a scheduler that draws to \p ostream every \p tick
+    explicit AnimationScheduler(std::ostream& ostream,
+                                std::chrono::milliseconds tick = DefaultTick);
+
+    AnimationScheduler(AnimationScheduler const&) = delete;
+    AnimationScheduler& operator=(AnimationScheduler const&) = delete;
+
+    /// Stops the timer thread. All animations must be stopped before.
+    ~AnimationScheduler();
+
+    /// \Returns the process wide scheduler drawing to `std::cout`
+    static AnimationScheduler& global();
+
+    /// \Returns the stream the animations are drawn to
+    std::ostream& ostream() const { return *out; }
+
+    /// \Returns the counters of written and suppressed output
+    AnimationStats stats() const;
+
+private:
+    friend class Animation;
+
+    /// Number of slots of the timer wheel
+    static constexpr std::size_t NumSlots = 256;
+
+    struct Timer {
+        Animation* animation;
+        std::size_t rounds;
+    };
+
+    void add(Animation& animation);
+    void remove(Animation& animation, std::string_view epilogue);
+    void schedule(Animation& animation, std::size_t ticks);
+    void run();
+    void advance();
+
+    std::ostream* out;
+    std::chrono::milliseconds tick;
+    mutable std::mutex mutex;
+    std::condition_variable cv;
+    std::thread thread;
+    std::vector<Timer> wheel[NumSlots];
+    std::vector<Animation*> due;
+    std::string buffer;
+    AnimationStats counters;
+    std::size_t cursor = 0;
+    std::size_t numActive = 0;
+    bool stopping = false;
+};
+
+/// Position and timing of an `Animation`
+struct AnimationOptions {
+    /// Time between two frames
+    std::chrono::milliseconds interval{ 80 };
+
+    /// Number of lines above the cursor line the animation is drawn in
+    std::size_t row = 0;
+
+    /// Column the animation is drawn at, counted from zero
+    std::size_t column = 0;
+
+    /// Overwrite the animation with spaces when it is stopped
+    bool clearOnStop = true;
+};
+
+/// Sequence of frames cycled by an `AnimationScheduler`
+/// \details Every frame is rendered once on construction into the complete
+/// byte sequence that draws it: the cursor movement to its position, the
+/// ANSI codes of the modifier, the text and the codes restoring the cursor
+/// and format. Drawing a frame is a single copy into the write buffer of the
+/// scheduler. The animation runs from construction until `stop()` or
+/// destruction. Animations are only drawn if the stream of the scheduler is
+/// term formattable.
+class TFMT_API Animation {
+public:
+    /// Run the frames \p frames styled with \p mod
+    explicit Animation(std::span<std::string_view const> frames,
+                       Modifier const& mod,
+                       AnimationOptions options = {},
+                       AnimationScheduler& scheduler =
+                           AnimationScheduler::global());
+
+    Animation(Animation const&) = delete;
+    Animation& operator=(Animation const&) = delete;
+
+    /// Calls `stop()`
+    virtual ~Animation();
+
+    /// Stop the animation. After this call the animation is not drawn
+    /// anymore.
+    void stop();
+
+    /// \Returns `true` if the animation has not been stopped
+    bool isRunning() const { return running; }
+
+private:
+    friend class AnimationScheduler;
+
+    std::string_view nextFrame();
+
+    AnimationScheduler& scheduler;
+    std::vector<std::string> frames;
+    std::string clearSequence;
+    /// Frame on screen, empty before the first frame is drawn
+    std::string_view drawnFrame;
+    std::size_t intervalTicks;
+    std::size_t frameIndex = 0;
+    std::size_t slot = 0;
+    bool running = false;
+};
+
+/// Spinner drawn with the braille frames `⠋⠙⠹⠸⠼⠴⠦⠧⠇⠏`
+class TFMT_API Spinner: public Animation {
+public:
+    explicit Spinner(Modifier const& mod,
+                     AnimationOptions options = {},
+                     AnimationScheduler& scheduler =
+                         AnimationScheduler::global());
+};
+
+} // namespace tfmt
+
+#endif // TERMFORMAT_ANIMATION_H_
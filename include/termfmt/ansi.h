@@ -0,0 +1,151 @@
+#ifndef TERMFORMAT_ANSI_H_
+#define TERMFORMAT_ANSI_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+
+#include <termfmt/api.h>
+
+namespace tfmt {
+
+/// Kind of an `AnsiEvent`
+enum class AnsiEventKind {
+    /// Run of text without control characters
+    Text,
+
+    /// C0 control character other than ESC, e.g. a line feed or a tab
+    Control,
+
+    /// SGR sequence `ESC [ ... m` that changes the text style
+    Style,
+
+    /// Any other CSI sequence `ESC [ ... <final>`, e.g. a cursor movement
+    CSI,
+
+    /// Operating system command `ESC ] ... ST`, e.g. a hyperlink or a window
+    /// title
+    OSC,
+
+    /// Device control string `ESC P ... ST` and the other string sequences
+    /// started by `ESC X`, `ESC ^` and `ESC _`
+    DCS,
+
+    /// Any other escape sequence `ESC <intermediates> <final>`
+    Escape,
+};
+
+/// Event reported by `AnsiParser`
+struct AnsiEvent {
+    AnsiEventKind kind;
+
+    /// `Text`: The text. `Control`: The control character. `CSI` and
+    /// `Style`: The parameter and intermediate bytes. `OSC` and `DCS`: The
+    /// payload without the terminator. `Escape`: The intermediate bytes.
+    std::string_view text;
+
+    /// Final byte of CSI and escape sequences, the introducer of string
+    /// sequences (`]`, `P`, `X`, `^` or `_`) and the control character of
+    /// `Control` events
+    char final = 0;
+
+    /// Numeric parameters of `Style` events. Empty for `ESC [ m`.
+    std::span<unsigned const> params = {};
+
+    /// Bit `i` is set if `params[i]` is a subparameter that follows a `:`,
+    /// so a group of parameters separated by `;` starts at every cleared bit.
+    /// E.g. `ESC [ 1 ; 4 : 3 m` has the groups `1` and `4:3`.
+    std::uint32_t subparams = 0;
+};
+
+/// Incremental parser of text with ANSI escape sequences
+/// \details The parser splits its input into text runs, control characters
+/// and escape sequences. Input is fed in chunks of any size, and sequences
+/// may be split across chunks. Text runs are found with SIMD instructions
+/// where available, and the parser never allocates: text and sequences
+/// that lie within one chunk are reported as views into the chunk, and only
+/// the bytes of sequences that span chunks are copied into a fixed size
+/// buffer. Longer split sequences are truncated.
+///
+/// Text runs are reported as they are found, so a run or a UTF-8 encoded
+/// code point may be split into two events at the end of a chunk.
+///
+/// \code
+/// tfmt::AnsiParser parser;
+/// parser.feed(chunk);
+/// while (auto event = parser.next()) {
+///     ...
+/// }
+/// \endcode
+class TFMT_API AnsiParser {
+public:
+    /// Maximum number of bytes of a split sequence
+    static constexpr std::size_t MaxSequenceSize = 256;
+
+    /// Maximum number of parameters of a `Style` event
+    static constexpr std::size_t MaxParams = 32;
+    static_assert(MaxParams <= 32, "`AnsiEvent::subparams` has 32 bits");
+
+    /// Continue parsing with \p chunk . The events of the previous chunk
+    /// must have been consumed.
+    void feed(std::string_view chunk);
+
+    /// \Returns the next event of the current chunk or `std::nullopt` if the
+    /// chunk has been consumed
+    /// \details Views in the event are valid until the next call to `next()`
+    /// or `feed()`.
+    std::optional<AnsiEvent> next();
+
+    /// \Returns the number of bytes of the current chunk that have been
+    /// consumed
+    std::size_t consumed() const { return pos; }
+
+    /// \Returns `true` if the parser is within an escape sequence
+    bool inSequence() const { return state != State::Ground; }
+
+    /// Forget a partially parsed sequence
+    void reset();
+
+private:
+    enum class State {
+        Ground,
+        Escape,
+        CSI,
+        String,
+        StringEscape,
+    };
+
+    std::optional<AnsiEvent> parseSequence();
+    AnsiEvent finishSequence(AnsiEventKind kind, char final, std::size_t end);
+    AnsiEvent makeCSIEvent(std::string_view body, char final);
+
+    std::string_view chunk;
+    std::size_t pos = 0;
+    State state = State::Ground;
+    /// Introducer of the current string sequence
+    char introducer = 0;
+    /// Offset of the body of the current sequence in `chunk`
+    std::size_t sequenceBegin = 0;
+    /// `true` if the beginning of the current sequence is in `buffer`
+    bool buffered = false;
+    std::size_t bufferSize = 0;
+    std::array<char, MaxSequenceSize> buffer;
+    std::array<unsigned, MaxParams> params;
+};
+
+/// Invoke \p fn with every event of the complete text \p text
+template <typename F>
+void parseAnsi(std::string_view text, F&& fn) {
+    AnsiParser parser;
+    parser.feed(text);
+    while (auto event = parser.next()) {
+        fn(*event);
+    }
+}
+
+} // namespace tfmt
+
+#endif // TERMFORMAT_ANSI_H_
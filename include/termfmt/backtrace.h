@@ -0,0 +1,83 @@
+#ifndef TERMFORMAT_BACKTRACE_H_
+#define TERMFORMAT_BACKTRACE_H_
+
+#include <cstddef>
+#include <iosfwd>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include <termfmt/api.h>
+
+namespace tfmt {
+
+/// Symbolic information about a single frame of a `Backtrace`
+/// \details The string views refer to a process wide symbol cache and stay
+/// valid until the program terminates.
+struct StackFrame {
+    /// Return address of the frame
+    void const* address = nullptr;
+
+    /// Demangled name of the enclosing function. Empty if unknown.
+    std::string_view function;
+
+    /// Path of the executable or shared object containing `address`. Empty if
+    /// unknown.
+    std::string_view module;
+
+    /// Offset of `address` from the start of `function`. Zero if the function
+    /// is unknown.
+    std::size_t offset = 0;
+
+    /// Offset of `address` from the load address of `module`, as expected by
+    /// `addr2line` and `objdump` for shared objects and position independent
+    /// executables. Zero if the module is unknown.
+    std::size_t moduleOffset = 0;
+};
+
+/// Call stack of a thread captured by `Backtrace::capture()`
+/// \details Capturing only records return addresses. Frames are symbolized
+/// on first access through a process wide cache, so repeated traces through
+/// the same call sites resolve without querying the dynamic linker again and
+/// every symbol is demangled only once.
+class TFMT_API Backtrace {
+public:
+    /// Capture the call stack of the calling thread.
+    /// \param skip Number of innermost frames to omit. The frame of `capture()`
+    /// itself is always omitted.
+    /// \param maxFrames Maximum number of frames to record
+    static Backtrace capture(std::size_t skip = 0, std::size_t maxFrames = 64);
+
+    /// Number of captured frames
+    std::size_t size() const { return addrs.size(); }
+
+    /// \Returns `true` if no frames have been captured
+    bool empty() const { return addrs.empty(); }
+
+    /// \Returns the raw return addresses of the captured frames, innermost
+    /// first
+    std::span<void* const> addresses() const { return addrs; }
+
+    /// \Returns the symbolized frame at \p index
+    StackFrame frame(std::size_t index) const;
+
+private:
+    std::vector<void*> addrs;
+};
+
+/// Print \p backtrace to \p ostream , one frame per line
+/// \details Frame number, function and module are printed in aligned, styled
+/// columns. Function names wider than the available width are truncated.
+TFMT_API void printBacktrace(std::ostream& ostream, Backtrace const& backtrace);
+
+/// \overload
+/// Print \p backtrace to `stdout`
+TFMT_API void printBacktrace(Backtrace const& backtrace);
+
+/// Print \p backtrace with `printBacktrace()`
+TFMT_API std::ostream& operator<<(std::ostream& ostream,
+                                  Backtrace const& backtrace);
+
+} // namespace tfmt
+
+#endif // TERMFORMAT_BACKTRACE_H_
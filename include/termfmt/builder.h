@@ -0,0 +1,166 @@
+#ifndef TERMFORMAT_BUILDER_H_
+#define TERMFORMAT_BUILDER_H_
+
+#include <array>
+#include <cassert>
+#include <charconv>
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include <termfmt/api.h>
+#include <termfmt/termfmt.h>
+
+namespace tfmt {
+
+/// Appends styled text to a caller owned buffer without going through
+/// `std::ostream`
+/// \details The builder keeps its own stack of modifiers, and `push()` and
+/// `pop()` emit the same ANSI format codes as `pushModifier()` and
+/// `popModifier()` on a formattable stream. Modifiers that are still pushed
+/// are popped on destruction, like `FormatGuard` does. Nothing is called
+/// through virtual functions.
+///
+/// The buffer is either a `std::string` that is appended to, or a fixed
+/// array. A fixed array always keeps room for the codes that undo the pushed
+/// modifiers, so the style never leaks into what is printed after the
+/// array. Text that does not fit is cut at a code point boundary and all
+/// following text is dropped. A modifier whose codes do not fit is not
+/// applied. In both cases `truncated()` is set.
+///
+/// \code
+/// std::string line;
+/// tfmt::StyledBuilder builder(line);
+/// builder.push(tfmt::Bold);
+/// builder << "Answer: " << 42;
+/// builder.pop();
+/// \endcode
+class TFMT_API StyledBuilder {
+public:
+    /// Maximum number of modifiers pushed at the same time
+    static constexpr std::size_t MaxDepth = 32;
+
+    /// Append to \p out
+    explicit StyledBuilder(std::string& out): string(&out) {}
+
+    /// Write into \p buffer
+    explicit StyledBuilder(std::span<char> buffer):
+        data(buffer.data()), capacity(buffer.size()) {}
+
+    StyledBuilder(StyledBuilder const&) = delete;
+    StyledBuilder& operator=(StyledBuilder const&) = delete;
+
+    /// Pops all modifiers
+    ~StyledBuilder();
+
+    /// Apply \p mod to the following text until the matching `pop()`
+    void push(Modifier const& mod);
+
+    /// Undo the last pushed modifier
+    void pop();
+
+    /// Append \p value . Strings and characters, including `signed char`
+    /// and `unsigned char`, are appended as they are. Numbers and `bool` are
+    /// formatted like `std::ostream` with default flags does, floating point
+    /// numbers with six significant digits.
+    template <typename T>
+    StyledBuilder& append(T const& value);
+
+    /// Append \p values with \p mod applied
+    template <typename... T>
+    StyledBuilder& appendStyled(Modifier const& mod, T const&... values) {
+        push(mod);
+        (append(values), ...);
+        pop();
+        return *this;
+    }
+
+    /// Same as `append()`
+    template <typename T>
+    StyledBuilder& operator<<(T const& value) {
+        return append(value);
+    }
+
+    /// \Returns the text written by this builder into a fixed array, or the
+    /// whole string
+    std::string_view view() const {
+        return string ? std::string_view(*string) :
+                        std::string_view(data, size);
+    }
+
+    /// \Returns `true` if output has been dropped because the fixed array is
+    /// full
+    bool truncated() const { return isTruncated; }
+
+private:
+    void write(std::string_view text);
+    void writeCodes(std::string_view codes);
+
+    std::string* string = nullptr;
+    char* data = nullptr;
+    std::size_t size = 0;
+    std::size_t capacity = 0;
+    bool isTruncated = false;
+    std::size_t depth = 0;
+    /// The attributes in effect while the modifiers are on top
+    std::array<internal::Attributes, MaxDepth> states;
+    /// Size of the codes that pop the modifiers, for fixed arrays
+    std::array<std::size_t, MaxDepth> offSizes;
+    /// Room kept in a fixed array for popping all modifiers
+    std::size_t reserved = 0;
+    /// Format codes for fixed arrays
+    std::string codes;
+};
+
+/// Append \p values to \p out with \p mod applied
+/// \details The bytes are the same as those of
+/// `stream << tfmt::format(mod, values...)` on a formattable stream with
+/// default flags.
+template <typename... T>
+void appendStyled(std::string& out, Modifier const& mod, T const&... values) {
+    StyledBuilder(out).appendStyled(mod, values...);
+}
+
+} // namespace tfmt
+
+template <typename T>
+tfmt::StyledBuilder& tfmt::StyledBuilder::append(T const& value) {
+    if constexpr (std::is_same_v<T, bool>) {
+        write(value ? "1" : "0");
+    }
+    else if constexpr (std::is_same_v<T, char> ||
+                       std::is_same_v<T, signed char> ||
+                       std::is_same_v<T, unsigned char>)
+    {
+        char const c = static_cast<char>(value);
+        write(std::string_view(&c, 1));
+    }
+    else if constexpr (std::is_convertible_v<T const&, std::string_view>) {
+        write(std::string_view(value));
+    }
+    else if constexpr (std::is_floating_point_v<T>) {
+        // `%g` with the default precision of streams
+        char buffer[64];
+        auto const result = std::to_chars(std::begin(buffer),
+                                          std::end(buffer),
+                                          value,
+                                          std::chars_format::general,
+                                          6);
+        write(std::string_view(buffer, result.ptr));
+    }
+    else if constexpr (std::is_arithmetic_v<T>) {
+        char buffer[64];
+        auto const result =
+            std::to_chars(std::begin(buffer), std::end(buffer), value);
+        write(std::string_view(buffer, result.ptr));
+    }
+    else {
+        static_assert(std::is_arithmetic_v<T>,
+                      "StyledBuilder can only append strings and numbers");
+    }
+    return *this;
+}
+
+#endif // TERMFORMAT_BUILDER_H_
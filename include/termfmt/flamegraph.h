@@ -0,0 +1,76 @@
+#ifndef TERMFORMAT_FLAMEGRAPH_H_
+#define TERMFORMAT_FLAMEGRAPH_H_
+
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string_view>
+
+#include <termfmt/api.h>
+
+namespace tfmt {
+
+namespace internal {
+
+class FlameGraphTree;
+
+} // namespace internal
+
+/// Options of `FlameGraph::render()`
+struct FlameGraphOptions {
+    /// Number of columns of the graph. If not set, the width of the stream
+    /// as returned by `getWidth()` is used, or 80 if the stream has no
+    /// width.
+    std::optional<std::size_t> width;
+
+    /// Maximum number of rows. Zero means unbounded.
+    std::size_t maxDepth = 0;
+};
+
+/// Aggregates stack samples and renders them as a text icicle graph
+/// \details Stacks are merged into a prefix tree whose nodes and frame names
+/// are allocated from an arena, so adding samples does not allocate per
+/// frame. The graph is rendered with the root in the first row and one row
+/// per stack depth. Every frame occupies a number of columns proportional to
+/// its sample count and is colored with a modifier selected by a hash of
+/// its name, so the same function has the same color everywhere.
+class TFMT_API FlameGraph {
+public:
+    FlameGraph();
+
+    FlameGraph(FlameGraph&&) noexcept;
+    FlameGraph& operator=(FlameGraph&&) noexcept;
+
+    ~FlameGraph();
+
+    /// Add one line in folded stack format: Frames from the outermost to the
+    /// innermost separated by `;`, followed by a space and the sample count,
+    /// e.g. `main;run;parse 42`
+    /// \Returns `false` if \p line is malformed. Malformed lines are
+    /// ignored.
+    bool addFolded(std::string_view line);
+
+    /// Add all lines of \p text with `addFolded()`. Empty lines are skipped.
+    /// \Returns the number of malformed lines
+    std::size_t parseFolded(std::string_view text);
+
+    /// Add \p count samples of the stack \p frames , ordered from the
+    /// outermost to the innermost frame
+    void addStack(std::span<std::string_view const> frames,
+                  std::uint64_t count = 1);
+
+    /// \Returns the total number of samples
+    std::uint64_t totalSamples() const;
+
+    /// Render the graph to \p ostream
+    void render(std::ostream& ostream, FlameGraphOptions options = {}) const;
+
+private:
+    std::unique_ptr<internal::FlameGraphTree> tree;
+};
+
+} // namespace tfmt
+
+#endif // TERMFORMAT_FLAMEGRAPH_H_
@@ -0,0 +1,44 @@
+#ifndef TERMFORMAT_GRAPHEME_H_
+#define TERMFORMAT_GRAPHEME_H_
+
+#include <cstddef>
+#include <string_view>
+
+#include <termfmt/api.h>
+
+namespace tfmt {
+
+/// Size and display width of a grapheme cluster
+struct Grapheme {
+    /// Number of bytes of the cluster
+    std::size_t size;
+
+    /// Number of terminal columns occupied by the cluster
+    std::size_t width;
+};
+
+/// \Returns the extended grapheme cluster at the beginning of the UTF-8
+/// encoded \p text
+/// \details Clusters are segmented by the rules of UAX #29, so a base
+/// character with its combining marks, an emoji ZWJ sequence, a flag or a
+/// Hangul syllable form one cluster. The width of a cluster is the largest
+/// width of its code points: zero for marks, format and control characters,
+/// two for East Asian wide and fullwidth characters and one for all others.
+/// Flags and clusters with an emoji presentation selector (U+FE0F) are two
+/// columns wide. Invalid UTF-8 bytes form clusters of their own and are one
+/// column wide. Returns `{ 0, 0 }` if \p text is empty.
+TFMT_API Grapheme nextGrapheme(std::string_view text);
+
+/// Invoke \p fn with every grapheme cluster of \p text and its width
+template <typename F>
+void forEachGrapheme(std::string_view text, F&& fn) {
+    while (!text.empty()) {
+        Grapheme const grapheme = nextGrapheme(text);
+        fn(text.substr(0, grapheme.size), grapheme.width);
+        text.remove_prefix(grapheme.size);
+    }
+}
+
+} // namespace tfmt
+
+#endif // TERMFORMAT_GRAPHEME_H_
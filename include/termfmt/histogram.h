@@ -0,0 +1,139 @@
+#ifndef TERMFORMAT_HISTOGRAM_H_
+#define TERMFORMAT_HISTOGRAM_H_
+
+#include <cstdint>
+#include <iosfwd>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include <termfmt/api.h>
+#include <termfmt/number.h>
+
+namespace tfmt {
+
+/// Streaming quantile sketch with relative error guarantees
+/// \details Samples are counted in logarithmically spaced buckets, like in
+/// DDSketch: every value `x` returned by `quantile()` is within
+/// `relativeAccuracy * x` of the true quantile. Memory is bounded by the
+/// number of buckets, which grows with the logarithm of the range of the
+/// samples and not with their count. If more than `maxBuckets` buckets are
+/// needed, the lowest buckets are merged, so the accuracy of high quantiles
+/// is preserved. Only non-negative samples are supported, negative samples
+/// are counted as zero.
+class TFMT_API QuantileSketch {
+public:
+    /// Create a sketch with the accuracy \p relativeAccuracy
+    explicit QuantileSketch(double relativeAccuracy = 0.01,
+                            std::size_t maxBuckets = 2048);
+
+    /// Add \p count samples of \p value
+    void add(double value, std::uint64_t count = 1);
+
+    /// Add all samples of \p other . Both sketches must have the same
+    /// accuracy.
+    void merge(QuantileSketch const& other);
+
+    /// \Returns the approximate \p q quantile for \p q in `[0, 1]`
+    /// \details Returns 0 if the sketch is empty.
+    double quantile(double q) const;
+
+    /// \Returns the number of samples
+    std::uint64_t count() const { return total; }
+
+    /// \Returns the smallest sample
+    double min() const { return minValue; }
+
+    /// \Returns the largest sample
+    double max() const { return maxValue; }
+
+    /// Invoke \p fn with the representative value and the count of every
+    /// non-empty bucket in ascending order
+    template <typename F>
+    void forEachBucket(F&& fn) const {
+        if (zeroCount > 0) {
+            fn(0.0, zeroCount);
+        }
+        for (std::size_t i = 0; i < counts.size(); ++i) {
+            if (counts[i] > 0) {
+                fn(bucketValue(minIndex + static_cast<int>(i)), counts[i]);
+            }
+        }
+    }
+
+private:
+    int bucketIndex(double value) const;
+    double bucketValue(int index) const;
+    void addToBucket(int index, std::uint64_t count);
+
+    double gamma;
+    double logGamma;
+    double minIndexable;
+    std::size_t maxBuckets;
+    std::vector<std::uint64_t> counts;
+    int minIndex = 0;
+    std::uint64_t zeroCount = 0;
+    std::uint64_t total = 0;
+    double minValue = 0;
+    double maxValue = 0;
+};
+
+/// Options of `Histogram::render()`
+struct HistogramOptions {
+    static constexpr double DefaultPercentiles[] = { 50, 90, 99, 99.9 };
+
+    /// Number of bars
+    std::size_t bins = 10;
+
+    /// Number of columns. If not set, the width of the stream as returned by
+    /// `getWidth()` is used, or 80 if the stream has no width.
+    std::optional<std::size_t> width;
+
+    /// Space the bins logarithmically, which suits long tailed data like
+    /// latencies
+    bool logScale = true;
+
+    /// Format of the bin labels and percentiles
+    NumberFormat format = { .precision = 1 };
+
+    /// Bars and percentiles are colored with the modifier of the last
+    /// threshold whose limit is not greater than their value
+    std::span<Threshold const> thresholds = {};
+
+    /// Percentiles printed below the bars, in `[0, 100]`
+    std::span<double const> percentiles = DefaultPercentiles;
+};
+
+/// Collects samples in a `QuantileSketch` and prints them as a horizontal
+/// bar histogram with a percentile summary
+class TFMT_API Histogram {
+public:
+    /// Create a histogram with the accuracy \p relativeAccuracy
+    explicit Histogram(double relativeAccuracy = 0.01);
+
+    /// Add one sample
+    void add(double value) { sketch.add(value); }
+
+    /// Add \p count samples of \p value
+    void add(double value, std::uint64_t count) { sketch.add(value, count); }
+
+    /// Add a precomputed bucket, e.g. of an HDR histogram, of \p count
+    /// samples up to \p upperBound
+    void addBucket(double upperBound, std::uint64_t count) {
+        sketch.add(upperBound, count);
+    }
+
+    /// \Returns the underlying sketch
+    QuantileSketch const& quantiles() const { return sketch; }
+
+    /// Print the histogram to \p ostream
+    void render(std::ostream& ostream,
+                HistogramOptions const& options = {}) const;
+
+private:
+    QuantileSketch sketch;
+};
+
+} // namespace tfmt
+
+#endif // TERMFORMAT_HISTOGRAM_H_
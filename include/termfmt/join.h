@@ -0,0 +1,207 @@
+#ifndef TERMFORMAT_JOIN_H_
+#define TERMFORMAT_JOIN_H_
+
+#include <concepts>
+#include <functional>
+#include <ostream>
+#include <ranges>
+#include <type_traits>
+#include <utility>
+#include <version>
+
+#if __cpp_lib_format >= 201907L
+#include <format>
+#endif
+
+#include <termfmt/termfmt.h>
+
+namespace tfmt {
+
+namespace internal {
+
+template <std::ranges::input_range R, typename Sep, typename StyleFn>
+class JoinView;
+
+/// Style function of `join(range, sep)`: elements with a style assigned by
+/// `StyleTraits` are styled, all other elements are printed as is
+struct DefaultJoinStyle {
+    template <typename T>
+    Modifier const* operator()(T const& value) const {
+        if constexpr (Styleable<T>) {
+            return &StyleTraits<T>::modifier(value);
+        }
+        else {
+            return nullptr;
+        }
+    }
+};
+
+/// Satisfied by functions that map elements of \p R to a `Modifier const&`,
+/// or to a `Modifier const*` where `nullptr` leaves an element unstyled
+template <typename F, typename R>
+concept JoinStyleFunction =
+    std::invocable<F const&, std::ranges::range_reference_t<R>> &&
+    (std::same_as<std::invoke_result_t<F const&,
+                                       std::ranges::range_reference_t<R>>,
+                  Modifier const&> ||
+     std::convertible_to<std::invoke_result_t<
+                             F const&,
+                             std::ranges::range_reference_t<R>>,
+                         Modifier const*>);
+
+} // namespace internal
+
+/// Lazily join the elements of \p range separated by \p sep
+/// \details The returned view is printed with `operator<<` or `std::format`.
+/// Printing iterates \p range exactly once and inserts every element
+/// directly into the stream, so no intermediate strings are created. Each
+/// element is styled with the modifier returned by \p styleFn . A run of
+/// consecutive elements with the same modifier is printed with a single
+/// style transition, the separators within the run share its style.
+/// Separators between elements of different styles are printed unstyled.
+/// Modifiers are compared by address and must outlive the printing.
+///
+/// The view refers to \p range if it is an lvalue and takes ownership
+/// otherwise, like `std::views::all`.
+template <std::ranges::input_range R,
+          typename Sep,
+          internal::JoinStyleFunction<R> StyleFn>
+internal::JoinView<std::views::all_t<R>, std::decay_t<Sep>, StyleFn> join(
+    R&& range, Sep&& sep, StyleFn styleFn) {
+    return internal::JoinView<std::views::all_t<R>,
+                              std::decay_t<Sep>,
+                              StyleFn>(std::views::all(std::forward<R>(range)),
+                                       std::forward<Sep>(sep),
+                                       std::move(styleFn));
+}
+
+/// \overload
+/// Elements are styled by `StyleTraits` if they are `Styleable`
+template <std::ranges::input_range R, typename Sep>
+internal::JoinView<std::views::all_t<R>,
+                   std::decay_t<Sep>,
+                   internal::DefaultJoinStyle>
+    join(R&& range, Sep&& sep) {
+    return join(std::forward<R>(range),
+                std::forward<Sep>(sep),
+                internal::DefaultJoinStyle{});
+}
+
+} // namespace tfmt
+
+// ===------------------------------------------------------===
+// === Implementation --------------------------------------===
+// ===------------------------------------------------------===
+
+template <std::ranges::input_range R, typename Sep, typename StyleFn>
+class tfmt::internal::JoinView {
+public:
+    explicit JoinView(R range, Sep sep, StyleFn styleFn):
+        range(std::move(range)),
+        sep(std::move(sep)),
+        styleFn(std::move(styleFn)) {}
+
+    template <typename CharT, typename Traits>
+    friend std::basic_ostream<CharT, Traits>& operator<<(
+        std::basic_ostream<CharT, Traits>& ostream, JoinView const& view) {
+        view.forEach(
+            [&](auto&& value) { ostream << value; },
+            [&] { ostream << view.sep; },
+            [&](Modifier const& mod) { pushModifierRef(mod, ostream); },
+            [&](Modifier const&) { popModifier(ostream); });
+        return ostream;
+    }
+
+    /// Walk the range once and call \p putElement and \p putSep in order,
+    /// with \p push and \p pop around runs of equally styled elements
+    void forEach(auto&& putElement,
+                 auto&& putSep,
+                 auto&& push,
+                 auto&& pop) const {
+        Modifier const* current = nullptr;
+        bool first = true;
+        auto popCurrent = [&] {
+            // Clear before calling pop so we won't pop twice if pop throws
+            if (current) {
+                pop(*std::exchange(current, nullptr));
+            }
+        };
+        // Pops the active style at the end, also if inserting an element
+        // throws
+        struct Guard {
+            ~Guard() { fn(); }
+            decltype(popCurrent)& fn;
+        } guard{ popCurrent };
+        for (auto&& value: range) {
+            Modifier const* const mod = style(value);
+            if (mod != current) {
+                popCurrent();
+                if (!first) {
+                    putSep();
+                }
+                if (mod) {
+                    push(*mod);
+                    current = mod;
+                }
+            }
+            else if (!first) {
+                putSep();
+            }
+            putElement(value);
+            first = false;
+        }
+    }
+
+    /// \Returns the separator
+    Sep const& separator() const { return sep; }
+
+private:
+    Modifier const* style(auto&& value) const {
+        if constexpr (std::is_reference_v<decltype(std::invoke(styleFn,
+                                                               value))>)
+        {
+            return &std::invoke(styleFn, value);
+        }
+        else {
+            return std::invoke(styleFn, value);
+        }
+    }
+
+    /// Input ranges are not necessarily iterable when const, so printing the
+    /// view mutates it
+    mutable R range;
+    Sep sep;
+    StyleFn styleFn;
+};
+
+#if __cpp_lib_format >= 201907L
+
+/// Formats the view like `operator<<` into a terminal, i.e. styles are
+/// emitted as ANSI format codes
+template <typename R, typename Sep, typename StyleFn>
+struct std::formatter<tfmt::internal::JoinView<R, Sep, StyleFn>, char> {
+    constexpr auto parse(std::format_parse_context& ctx) {
+        return ctx.begin();
+    }
+
+    template <typename FormatContext>
+    auto format(tfmt::internal::JoinView<R, Sep, StyleFn> const& view,
+                FormatContext& ctx) const {
+        auto out = ctx.out();
+        auto putCodes = [&](std::string_view codes) {
+            out = std::copy(codes.begin(), codes.end(), out);
+        };
+        view.forEach(
+            [&](auto&& value) { out = std::format_to(out, "{}", value); },
+            [&] { out = std::format_to(out, "{}", view.separator()); },
+            [&](tfmt::Modifier const& mod) { putCodes(mod.ansiBuffer()); },
+            [&](tfmt::Modifier const& mod) {
+                putCodes(mod.ansiOffBuffer());
+            });
+        return out;
+    }
+};
+
+#endif // __cpp_lib_format
+
+#endif // TERMFORMAT_JOIN_H_
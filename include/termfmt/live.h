@@ -0,0 +1,83 @@
+#ifndef TERMFORMAT_LIVE_H_
+#define TERMFORMAT_LIVE_H_
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <termfmt/api.h>
+
+namespace tfmt {
+
+/// Counters of a `LiveView`
+struct LiveViewStats {
+    /// Number of calls to `LiveView::update()`
+    std::uint64_t frames = 0;
+
+    /// Number of frames that were identical to the frame on screen, so
+    /// nothing was written
+    std::uint64_t suppressedFrames = 0;
+
+    /// Number of lines that were identical to the line on screen
+    std::uint64_t suppressedLines = 0;
+
+    /// Number of bytes written to the stream
+    std::uint64_t bytesWritten = 0;
+
+    /// Number of bytes that redrawing every frame completely would have
+    /// written in addition
+    std::uint64_t bytesSuppressed = 0;
+};
+
+/// Block of lines that is redrawn in place, e.g. a dashboard or a set of
+/// progress bars
+/// \details The view occupies the lines above the cursor. Every frame is
+/// compared with the frame on screen line by line by hash, and only the
+/// lines that changed are rewritten; the cursor skips over the others. If no
+/// line changed, nothing is written at all, so an idle view generates no
+/// terminal traffic. Lines are cut to the width of the stream, if it has
+/// one, so they never wrap and the line count stays exact. Changed lines are
+/// erased before their text is written, so a line that fills the width keeps
+/// its last character.
+///
+/// If the stream is not term formattable, frames are printed one after the
+/// other and frames identical to the previous one are dropped.
+///
+/// A view must only be used by one thread at a time, and nothing else may be
+/// printed to the stream while it is used, except after `clear()`.
+class TFMT_API LiveView {
+public:
+    /// Draw to \p ostream
+    explicit LiveView(std::ostream& ostream);
+
+    LiveView(LiveView const&) = delete;
+    LiveView& operator=(LiveView const&) = delete;
+
+    /// Draw \p frame in place of the previous frame. Lines are separated by
+    /// line feeds, and a final line feed is ignored.
+    void update(std::string_view frame);
+
+    /// Erase the view. The next frame is drawn below the output printed in
+    /// the meantime.
+    void clear();
+
+    /// \Returns the counters of suppressed output
+    LiveViewStats const& stats() const { return counters; }
+
+private:
+    void write();
+
+    std::ostream& out;
+    /// Hashes of the lines on screen
+    std::vector<std::uint64_t> hashes;
+    std::vector<std::uint64_t> newHashes;
+    std::vector<std::string_view> lines;
+    std::string buffer;
+    LiveViewStats counters;
+};
+
+} // namespace tfmt
+
+#endif // TERMFORMAT_LIVE_H_
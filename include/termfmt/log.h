@@ -0,0 +1,146 @@
+#ifndef TERMFORMAT_LOG_H_
+#define TERMFORMAT_LOG_H_
+
+#include <atomic>
+#include <iosfwd>
+#include <source_location>
+#include <string_view>
+#include <utility>
+
+#include <termfmt/api.h>
+
+/// Lowest level that is compiled into the program. Log statements below this
+/// level are discarded at compile time and never evaluate their arguments.
+/// Define to one of the enumerators of `tfmt::LogLevel`, e.g.
+/// `-DTFMT_LOG_MIN_LEVEL=Warning`
+#ifndef TFMT_LOG_MIN_LEVEL
+#define TFMT_LOG_MIN_LEVEL Trace
+#endif
+
+namespace tfmt {
+
+/// Severity of a log message
+enum class LogLevel { Trace, Debug, Info, Warning, Error, Fatal, Off };
+
+/// Level threshold fixed at compile time by `TFMT_LOG_MIN_LEVEL`
+inline constexpr LogLevel CompileTimeLogLevel = LogLevel::TFMT_LOG_MIN_LEVEL;
+
+/// `true` if messages of level \p Level survive the compile time threshold
+template <LogLevel Level>
+inline constexpr bool isLogLevelCompiled =
+    Level != LogLevel::Off && Level >= CompileTimeLogLevel;
+
+namespace internal {
+
+TFMT_API extern std::atomic<LogLevel> runtimeLogLevel;
+
+} // namespace internal
+
+/// Set the runtime level threshold. Messages below \p level are dropped
+/// before their arguments are evaluated.
+TFMT_API void setLogLevel(LogLevel level);
+
+/// \Returns the runtime level threshold
+inline LogLevel getLogLevel() {
+    return internal::runtimeLogLevel.load(std::memory_order_relaxed);
+}
+
+/// \Returns `true` if messages of level \p level are currently emitted
+inline bool isLogEnabled(LogLevel level) {
+    return level != LogLevel::Off && level >= getLogLevel();
+}
+
+/// \Returns the name of \p level as printed in log prefixes, e.g. `"INFO"`
+TFMT_API std::string_view logLevelName(LogLevel level);
+
+/// Optional fields of log line prefixes
+enum class LogPrefixFlags : unsigned {
+    None = 0,
+    /// Local wall clock time with millisecond resolution
+    Timestamp = 1 << 0,
+    /// `file:line` of the log statement
+    Location = 1 << 1,
+    All = Timestamp | Location
+};
+
+inline constexpr LogPrefixFlags operator|(LogPrefixFlags lhs,
+                                          LogPrefixFlags rhs) {
+    return LogPrefixFlags(unsigned(lhs) | unsigned(rhs));
+}
+
+inline constexpr LogPrefixFlags operator&(LogPrefixFlags lhs,
+                                          LogPrefixFlags rhs) {
+    return LogPrefixFlags(unsigned(lhs) & unsigned(rhs));
+}
+
+/// Select the optional fields printed in front of the level of every log
+/// line. Defaults to `LogPrefixFlags::None`.
+TFMT_API void setLogPrefixFlags(LogPrefixFlags flags);
+
+/// \Returns the fields selected by `setLogPrefixFlags()`
+TFMT_API LogPrefixFlags getLogPrefixFlags();
+
+/// Write the styled prefix of a message of level \p level logged at
+/// \p location to \p ostream
+/// \details Level prefixes are rendered once per level and output backend.
+/// The rendered timestamp is cached per thread and second, only the
+/// millisecond digits are patched on every call. `file:line` strings are
+/// rendered once per thread and \p location . The location field is omitted
+/// if \p location is default constructed.
+template <typename CharT, typename Traits>
+TFMT_API void putLogPrefix(std::basic_ostream<CharT, Traits>& ostream,
+                           LogLevel level,
+                           std::source_location const& location = {});
+
+/// Write one log line consisting of the styled prefix of \p level and
+/// \p args... to \p ostream
+/// \details The line is dropped if \p Level is below the compile time or the
+/// runtime threshold. Note that \p args... are evaluated by the caller; use
+/// the `TFMT_LOG` macros to avoid evaluating them for dropped messages.
+template <LogLevel Level, typename CharT, typename Traits, typename... Args>
+void log(std::source_location const& location,
+         std::basic_ostream<CharT, Traits>& ostream,
+         Args&&... args) {
+    if constexpr (isLogLevelCompiled<Level>) {
+        if (isLogEnabled(Level)) {
+            putLogPrefix(ostream, Level, location);
+            ((ostream << std::forward<Args>(args)), ...);
+            ostream << '\n';
+        }
+    }
+}
+
+/// \overload
+/// Logs without source location
+template <LogLevel Level, typename CharT, typename Traits, typename... Args>
+void log(std::basic_ostream<CharT, Traits>& ostream, Args&&... args) {
+    log<Level>(std::source_location{}, ostream, std::forward<Args>(args)...);
+}
+
+} // namespace tfmt
+
+/// Log \p ... to \p ostream with level \p level
+/// \details \p level is the name of an enumerator of `tfmt::LogLevel`. The
+/// statement compiles to nothing if \p level is below `TFMT_LOG_MIN_LEVEL`.
+/// Otherwise the runtime threshold is checked before any argument (including
+/// `tfmt::format()` wrappers and modifiers) is constructed.
+#define TFMT_LOG(level, ostream, ...)                                          \
+    do {                                                                       \
+        if constexpr (::tfmt::isLogLevelCompiled<::tfmt::LogLevel::level>) {   \
+            if (::tfmt::isLogEnabled(::tfmt::LogLevel::level)) {               \
+                ::tfmt::log<::tfmt::LogLevel::level>(                          \
+                    ::std::source_location::current(),                         \
+                    ostream,                                                   \
+                    __VA_ARGS__);                                              \
+            }                                                                  \
+        }                                                                      \
+    } while (0)
+
+#define TFMT_LOG_TRACE(ostream, ...)   TFMT_LOG(Trace, ostream, __VA_ARGS__)
+#define TFMT_LOG_DEBUG(ostream, ...)   TFMT_LOG(Debug, ostream, __VA_ARGS__)
+#define TFMT_LOG_INFO(ostream, ...)    TFMT_LOG(Info, ostream, __VA_ARGS__)
+#define TFMT_LOG_WARNING(ostream, ...) TFMT_LOG(Warning, ostream, __VA_ARGS__)
+#define TFMT_LOG_ERROR(ostream, ...)   TFMT_LOG(Error, ostream, __VA_ARGS__)
+#define TFMT_LOG_FATAL(ostream, ...)   TFMT_LOG(Fatal, ostream, __VA_ARGS__)
+
+#endif // TERMFORMAT_LOG_H_
@@ -0,0 +1,152 @@
+#ifndef TERMFORMAT_NUMBER_H_
+#define TERMFORMAT_NUMBER_H_
+
+#include <array>
+#include <concepts>
+#include <cstdint>
+#include <iosfwd>
+#include <span>
+#include <string_view>
+
+#include <termfmt/api.h>
+
+namespace tfmt {
+
+class Modifier;
+
+namespace internal {
+
+class NumberFormatter;
+
+} // namespace internal
+
+/// Unit systems for human readable numbers
+enum class NumberUnit {
+    /// Plain number
+    None,
+    /// Powers of 1000 with SI prefixes: `k`, `M`, `G`, ...
+    SI,
+    /// Byte counts in powers of 1024: `B`, `KiB`, `MiB`, ...
+    Bytes,
+    /// Durations given in nanoseconds: `ns`, `µs`, `ms`, `s`
+    Nanoseconds,
+};
+
+/// Options of `formatNumber()`
+struct NumberFormat {
+    /// Number of digits after the decimal point. If negative, integers are
+    /// printed exactly, values scaled by a unit get one decimal and other
+    /// floating point values are printed in shortest round trip form.
+    int precision = -1;
+
+    /// Separate groups of three integer digits with `separator`
+    bool grouping = false;
+
+    /// Digit group separator
+    char separator = ',';
+
+    /// Scale the value into a human readable unit
+    NumberUnit unit = NumberUnit::None;
+
+    /// Right align the number to this many columns
+    std::size_t width = 0;
+};
+
+/// Select the modifier of numbers that are at least `limit`
+struct Threshold {
+    double limit;
+    Modifier const* modifier;
+};
+
+/// Number rendered into an inline buffer by `formatNumber()`
+class TFMT_API FormattedNumber {
+public:
+    /// Capacity of the inline buffer
+    static constexpr std::size_t Capacity = 48;
+
+    /// \Returns the text of the number without alignment padding
+    std::string_view text() const { return { buffer.data(), size }; }
+
+    /// \Returns the number of columns the number occupies including padding
+    std::size_t width() const;
+
+    /// \Returns the modifier selected by the thresholds or `nullptr`
+    Modifier const* modifier() const { return mod; }
+
+    /// Print \p number to \p ostream
+    /// \details The number is styled with the selected modifier and padded
+    /// with spaces on the left to the requested width.
+    template <typename CharT, typename Traits>
+    friend std::basic_ostream<CharT, Traits>& operator<<(
+        std::basic_ostream<CharT, Traits>& ostream,
+        FormattedNumber const& number) {
+        number.put(ostream);
+        return ostream;
+    }
+
+private:
+    friend class internal::NumberFormatter;
+
+    template <typename CharT, typename Traits>
+    void put(std::basic_ostream<CharT, Traits>& ostream) const;
+
+    std::array<char, Capacity> buffer;
+    std::uint8_t size = 0;
+    std::size_t alignWidth = 0;
+    Modifier const* mod = nullptr;
+};
+
+/// Format \p value according to \p format
+/// \details The number is rendered with `std::to_chars` into a buffer inside
+/// the returned object. Formatting neither allocates nor consults the
+/// locale. The modifier of the last threshold in \p thresholds whose limit is
+/// not greater than \p value is selected; \p thresholds must be sorted by
+/// limit in ascending order.
+TFMT_API FormattedNumber formatNumber(double value,
+                                      NumberFormat const& format = {},
+                                      std::span<Threshold const> thresholds =
+                                          {});
+
+/// \overload
+TFMT_API FormattedNumber formatNumber(std::int64_t value,
+                                      NumberFormat const& format = {},
+                                      std::span<Threshold const> thresholds =
+                                          {});
+
+/// \overload
+TFMT_API FormattedNumber formatNumber(std::uint64_t value,
+                                      NumberFormat const& format = {},
+                                      std::span<Threshold const> thresholds =
+                                          {});
+
+/// \overload
+/// Dispatches the remaining integer types to the 64 bit overloads
+template <std::integral T>
+    requires(!std::same_as<T, std::int64_t> && !std::same_as<T, std::uint64_t>)
+FormattedNumber formatNumber(T value,
+                             NumberFormat const& format = {},
+                             std::span<Threshold const> thresholds = {}) {
+    if constexpr (std::is_signed_v<T>) {
+        return formatNumber(static_cast<std::int64_t>(value),
+                            format,
+                            thresholds);
+    }
+    else {
+        return formatNumber(static_cast<std::uint64_t>(value),
+                            format,
+                            thresholds);
+    }
+}
+
+/// \overload
+template <std::floating_point T>
+    requires(!std::same_as<T, double>)
+FormattedNumber formatNumber(T value,
+                             NumberFormat const& format = {},
+                             std::span<Threshold const> thresholds = {}) {
+    return formatNumber(static_cast<double>(value), format, thresholds);
+}
+
+} // namespace tfmt
+
+#endif // TERMFORMAT_NUMBER_H_
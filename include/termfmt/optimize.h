@@ -0,0 +1,126 @@
+#ifndef TERMFORMAT_OPTIMIZE_H_
+#define TERMFORMAT_OPTIMIZE_H_
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+
+#include <termfmt/ansi.h>
+#include <termfmt/api.h>
+#include <termfmt/termfmt.h>
+
+namespace tfmt {
+
+/// Rewrites text with ANSI escape sequences so that style changes are
+/// encoded with the fewest bytes
+/// \details The optimizer tracks the style set by the SGR sequences of the
+/// input and only emits a transition when text follows, so consecutive
+/// sequences are coalesced and sequences that are undone before any text is
+/// printed disappear. Every transition is encoded either with targeted off
+/// codes or with a reset, whichever is shorter. SGR sequences with
+/// parameters that are not tracked, like overlines or underline colors, and
+/// all other escape sequences are copied verbatim after the pending style
+/// has been emitted. After an untracked attribute has been set, SGR
+/// sequences are copied verbatim until the next reset, so that the
+/// untracked attribute is undone where the input undoes it. Control
+/// characters don't render, so they don't emit the pending style.
+class TFMT_API SGROptimizer {
+public:
+    /// Append \p chunk rewritten to \p out . Sequences may be split across
+    /// chunks.
+    void optimize(std::string_view chunk, std::string& out);
+
+    /// Append the pending style to \p out , so the terminal shows the input
+    /// so far in its style. A sequence that continues in the next chunk is
+    /// kept.
+    void flush(std::string& out);
+
+    /// End the input: append the pending style and the bytes of an
+    /// incomplete sequence at the end of the input verbatim to \p out , so
+    /// no input is lost and the terminal ends up in the style of the input
+    void finish(std::string& out);
+
+    /// \Returns the number of bytes passed to `optimize()`
+    std::uint64_t bytesIn() const { return numBytesIn; }
+
+    /// \Returns the number of bytes appended by `optimize()`, `flush()` and
+    /// `finish()`
+    std::uint64_t bytesOut() const { return numBytesOut; }
+
+private:
+    void handle(AnsiEvent const& event,
+                std::string_view raw,
+                std::string& out);
+    void emitStyle(std::string& out);
+
+    AnsiParser parser;
+    /// Style in effect on the terminal
+    internal::Attributes emitted;
+    /// Style set by the input
+    internal::Attributes target;
+    /// `true` if the input may have set attributes that are not tracked
+    bool hasUntracked = false;
+    /// Raw bytes of a sequence that spans chunks
+    std::string partial;
+    std::string transition;
+    std::uint64_t numBytesIn = 0;
+    std::uint64_t numBytesOut = 0;
+};
+
+/// Stream buffer that optimizes the SGR sequences of its input as by
+/// `SGROptimizer` and writes the result to another stream
+class TFMT_API SGROptimizingStreambuf: public std::streambuf {
+public:
+    /// Write the optimized text to \p dest
+    explicit SGROptimizingStreambuf(std::ostream& dest);
+
+    SGROptimizingStreambuf(SGROptimizingStreambuf const&) = delete;
+    SGROptimizingStreambuf& operator=(SGROptimizingStreambuf const&) = delete;
+
+    /// Writes the buffered text and ends the input as by
+    /// `SGROptimizer::finish()`
+    ~SGROptimizingStreambuf() override;
+
+    /// \Returns the optimizer
+    SGROptimizer const& optimizer() const { return opt; }
+
+protected:
+    int_type overflow(int_type ch) override;
+
+    std::streamsize xsputn(char const* data, std::streamsize count) override;
+
+    /// Writes the pending style as well, so the destination shows everything
+    /// written so far in the right style
+    int sync() override;
+
+private:
+    void write(std::string_view text);
+    void drain();
+    void finish(bool endOfInput);
+
+    std::ostream& dest;
+    SGROptimizer opt;
+    std::string optimized;
+    std::array<char, 4096> buffer;
+};
+
+/// Output stream that optimizes the SGR sequences of its input
+/// \details The format flags of the destination stream are copied.
+class TFMT_API SGROptimizingStream: public std::ostream {
+public:
+    /// Write the optimized text to \p dest
+    explicit SGROptimizingStream(std::ostream& dest);
+
+    /// \Returns the optimizer, e.g. to report the number of bytes saved
+    SGROptimizer const& optimizer() const { return buf.optimizer(); }
+
+private:
+    SGROptimizingStreambuf buf;
+};
+
+} // namespace tfmt
+
+#endif // TERMFORMAT_OPTIMIZE_H_
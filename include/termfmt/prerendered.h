@@ -0,0 +1,104 @@
+#ifndef TERMFORMAT_PRERENDERED_H_
+#define TERMFORMAT_PRERENDERED_H_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <locale>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+#include <termfmt/api.h>
+#include <termfmt/termfmt.h>
+
+namespace tfmt {
+
+/// Styled fragment that is rendered once and then copied into streams
+/// \details Labels, headers and status tags are often printed with the same
+/// modifier and text over and over. `Prerendered` inserts the fragment into
+/// a string stream on first use and afterwards writes the cached bytes with
+/// one call to `std::ostream::write()`.
+///
+/// The bytes depend on the stream: on whether it is formattable with ANSI,
+/// HTML or SVG codes, on the attributes that the modifiers pushed to it have
+/// set and on its format flags, width, precision, fill character and locale,
+/// which the fragment is rendered with. A rendering is cached for every such
+/// combination that the fragment is inserted into, up to `MaxRenderings`.
+/// Like any formatted insertion, inserting the fragment resets the width of
+/// the stream to zero. Streams that differ
+/// from all cached ones get a fresh rendering, so a cached rendering is never
+/// used for a stream with different capabilities.
+///
+/// Insertion is thread safe. The objects are copied, so the fragment is
+/// immutable.
+///
+/// \code
+/// void reportError(std::string_view message) {
+///     static tfmt::Prerendered const error(tfmt::Bold | tfmt::Red,
+///                                          "error: ");
+///     std::cerr << error << message << "\n";
+/// }
+/// \endcode
+/// Like all modifiers, the predefined ones must not be used during static
+/// initialization, so fragments at namespace scope can't use them.
+class TFMT_API Prerendered {
+public:
+    /// Maximum number of cached renderings
+    static constexpr std::size_t MaxRenderings = 4;
+
+    /// Fragment of \p objects formatted with \p mod as by
+    /// `tfmt::format(mod, objects...)`
+    template <typename... T>
+    explicit Prerendered(Modifier mod, T&&... objects):
+        renderFn(
+            [wrapper = format(std::move(mod), std::forward<T>(objects)...)](
+                std::ostream& ostream) { ostream << wrapper; }) {}
+
+    Prerendered(Prerendered const&) = delete;
+    Prerendered& operator=(Prerendered const&) = delete;
+
+    ~Prerendered();
+
+    friend std::ostream& operator<<(std::ostream& ostream,
+                                    Prerendered const& fragment) {
+        fragment.put(ostream);
+        return ostream;
+    }
+
+private:
+    /// Capabilities and format state of a stream that the rendering depends
+    /// on
+    struct Key {
+        std::uint8_t flags;
+        internal::Attributes base;
+        std::ios_base::fmtflags fmtflags;
+        std::streamsize width;
+        std::streamsize precision;
+        char fill;
+        std::locale locale;
+
+        bool operator==(Key const&) const = default;
+    };
+
+    struct Rendering {
+        Key key;
+        std::string bytes;
+    };
+
+    void put(std::ostream& ostream) const;
+    Rendering const* find(Key const& key) const;
+    std::string render(Key const& key) const;
+
+    std::function<void(std::ostream&)> renderFn;
+    /// Renderings are only added and never changed, so they are read
+    /// without locking
+    mutable std::array<std::atomic<Rendering const*>, MaxRenderings>
+        renderings = {};
+    mutable std::mutex mutex;
+};
+
+} // namespace tfmt
+
+#endif // TERMFORMAT_PRERENDERED_H_
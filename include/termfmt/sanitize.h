@@ -0,0 +1,91 @@
+#ifndef TERMFORMAT_SANITIZE_H_
+#define TERMFORMAT_SANITIZE_H_
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+
+#include <termfmt/api.h>
+
+namespace tfmt {
+
+/// How `sanitize()` neutralizes control characters
+enum class SanitizeMode {
+    /// Drop control characters. Escape sequences are dropped as a whole, so
+    /// no parameter bytes are left behind.
+    Remove,
+
+    /// Replace control characters with their caret notation like `cat -v`,
+    /// e.g. `^[` for ESC and `^?` for DEL. The rest of an escape sequence is
+    /// printed as text, so it is visible what the input tried to do.
+    Caret,
+};
+
+/// Options of `sanitize()`
+struct SanitizeOptions {
+    SanitizeMode mode = SanitizeMode::Remove;
+
+    /// Set of C0 control characters that are passed through, bit `c` for
+    /// character `c`. Line feeds and tabs by default.
+    std::uint32_t allowedControls = 1u << '\t' | 1u << '\n';
+
+    /// Pass through SGR sequences `ESC [ ... m`, which only change the style
+    /// of the text
+    bool allowStyles = false;
+};
+
+/// \Returns \p text with all control characters and escape sequences that
+/// are not allowed by \p options neutralized
+/// \details This covers the C0 control characters including ESC, DEL and the
+/// C1 control characters U+0080 to U+009F, which some terminals interpret
+/// like ESC sequences, e.g. U+009B as CSI. Text without control characters
+/// is found with SIMD instructions where available and copied in bulk.
+TFMT_API std::string sanitize(std::string_view text,
+                              SanitizeOptions const& options = {});
+
+/// Print \p text sanitized as by `sanitize()` to \p ostream
+/// \details The runs of clean text are written directly, so no copy of
+/// \p text is made. Allowed SGR sequences are only printed if \p ostream is
+/// formattable, and the modifiers of \p ostream are reapplied afterwards, so
+/// a style set by \p text does not leak into the following output.
+TFMT_API void sanitize(std::ostream& ostream,
+                       std::string_view text,
+                       SanitizeOptions const& options = {});
+
+namespace internal {
+
+/// Inserts text sanitized as by `sanitize()`
+class UntrustedRef {
+public:
+    explicit UntrustedRef(std::string_view text, SanitizeOptions options):
+        text(text), options(options) {}
+
+    friend std::ostream& operator<<(std::ostream& ostream,
+                                    UntrustedRef const& ref) {
+        sanitize(ostream, ref.text, ref.options);
+        return ostream;
+    }
+
+private:
+    std::string_view text;
+    SanitizeOptions options;
+};
+
+} // namespace internal
+
+/// Marks \p text as untrusted, so it is sanitized as it is inserted into a
+/// stream
+/// \details Use this for user supplied arguments of `format()`:
+/// \code
+/// std::cout << tfmt::format(tfmt::Bold, "Hello ", tfmt::untrusted(name));
+/// \endcode
+/// The returned object only refers to \p text .
+inline internal::UntrustedRef untrusted(std::string_view text,
+                                        SanitizeOptions const& options = {}) {
+    return internal::UntrustedRef(text, options);
+}
+
+} // namespace tfmt
+
+#endif // TERMFORMAT_SANITIZE_H_
@@ -0,0 +1,122 @@
+#ifndef TERMFORMAT_SHARED_OUTPUT_H_
+#define TERMFORMAT_SHARED_OUTPUT_H_
+
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+
+#include <termfmt/api.h>
+
+namespace tfmt {
+
+namespace internal {
+
+class SharedOutputChannel;
+
+} // namespace internal
+
+/// Options of `SharedOutput`
+struct SharedOutputOptions {
+    /// Size of the ring buffer in bytes. Only used by the process that
+    /// creates the channel.
+    std::size_t capacity = std::size_t(1) << 20;
+
+    /// File descriptor the leader writes to
+    int fd = 1;
+};
+
+/// Channel through which several processes write complete lines to one
+/// terminal
+/// \details All processes that open a channel with the same name share a
+/// ring buffer in shared memory. Producers copy complete lines into the ring
+/// under a process shared mutex, so lines of different processes never
+/// interleave, not even in the middle of an escape sequence. One process,
+/// the leader, drains the ring to its file descriptor on a background
+/// thread, batching all pending lines into one write. The leader is the
+/// process that holds an exclusive `flock()` on the lock file of the
+/// channel, `tfmt-<name>.lock` in `$TMPDIR` or `/tmp`. If the leader exits,
+/// its lock is released and another process takes over on its next
+/// submission.
+///
+/// The shared memory object persists after all processes have exited, use
+/// `remove()` to delete it. If the channel can't be set up, e.g. because the
+/// lock file belongs to another user, or on platforms without POSIX shared
+/// memory, lines are written directly under a mutex local to the process.
+class TFMT_API SharedOutput {
+public:
+    /// Open or create the channel \p name
+    /// \details \p name may consist of letters, digits, `-` and `_`.
+    explicit SharedOutput(std::string_view name,
+                          SharedOutputOptions options = {});
+
+    SharedOutput(SharedOutput const&) = delete;
+    SharedOutput& operator=(SharedOutput const&) = delete;
+
+    /// Calls `flush()` and stops draining if this process is the leader
+    ~SharedOutput();
+
+    /// Submit the line \p line . A line break is appended if \p line does not
+    /// end with one.
+    /// \details Blocks while the ring is full. Lines that don't fit into the
+    /// ring at all are written directly once the ring is empty.
+    void submit(std::string_view line);
+
+    /// Block until all submitted lines have been written
+    void flush();
+
+    /// \Returns `true` if this process drains the channel
+    bool isLeader() const;
+
+    /// \Returns `true` if lines are exchanged through shared memory, `false`
+    /// if the process local fallback is used
+    bool isShared() const;
+
+    /// \Returns the file descriptor lines are written to
+    int fd() const;
+
+    /// Delete the shared memory object and lock file of channel \p name
+    static void remove(std::string_view name);
+
+private:
+    std::unique_ptr<internal::SharedOutputChannel> channel;
+};
+
+/// Stream buffer that submits complete lines to a `SharedOutput`
+class TFMT_API SharedOutputStreambuf: public std::streambuf {
+public:
+    explicit SharedOutputStreambuf(SharedOutput& output): output(output) {}
+
+    /// Submits an incomplete last line
+    ~SharedOutputStreambuf() override;
+
+protected:
+    int_type overflow(int_type ch) override;
+
+    std::streamsize xsputn(char const* data, std::streamsize count) override;
+
+    int sync() override;
+
+private:
+    void submitLines();
+
+    SharedOutput& output;
+    std::string pending;
+};
+
+/// Output stream that submits complete lines to a `SharedOutput`
+/// \details The stream is term formattable if the file descriptor of the
+/// channel is a terminal.
+class TFMT_API SharedOutputStream: public std::ostream {
+public:
+    explicit SharedOutputStream(SharedOutput& output);
+
+private:
+    SharedOutputStreambuf buf;
+};
+
+} // namespace tfmt
+
+#endif // TERMFORMAT_SHARED_OUTPUT_H_
@@ -0,0 +1,107 @@
+#ifndef TERMFORMAT_SIXEL_H_
+#define TERMFORMAT_SIXEL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <termfmt/api.h>
+
+namespace tfmt {
+
+/// Image passed to `SixelEncoder`
+struct SixelImage {
+    /// Pixels in rows from top to bottom, each with `channels` bytes: red,
+    /// green, blue and optionally alpha
+    std::span<std::uint8_t const> pixels;
+
+    std::size_t width = 0;
+    std::size_t height = 0;
+
+    /// 3 for RGB or 4 for RGBA
+    std::size_t channels = 4;
+};
+
+/// Options of `SixelEncoder`
+struct SixelOptions {
+    /// Maximum number of palette colors, at most 256
+    std::size_t maxColors = 256;
+
+    /// Pixels with an alpha value below this are not drawn
+    std::uint8_t alphaThreshold = 128;
+};
+
+/// Encodes images as sixel sequences, which terminals like xterm, mlterm and
+/// foot draw inline at full resolution
+/// \details Colors are quantized with the median cut algorithm into a
+/// palette of at most `SixelOptions::maxColors` colors. The colors of an
+/// image are first collected in a histogram of 15 bit buckets, five bits per
+/// channel, and the buckets are split into boxes along their longest axis at
+/// the median pixel count. Palettes are cached along with the bucket lookup
+/// table by the set of buckets an image uses, so the frames of an animated
+/// plot quantize with one table lookup per pixel after the first frame.
+///
+/// The sixel data is run length encoded. Every band of six rows paints only
+/// the colors that occur in it, and trailing empty columns are omitted.
+class TFMT_API SixelEncoder {
+public:
+    /// Number of cached palettes
+    static constexpr std::size_t CacheSize = 4;
+
+    explicit SixelEncoder(SixelOptions options = {});
+
+    /// Append the sixel sequence drawing \p image to \p out
+    void encode(SixelImage const& image, std::string& out);
+
+    /// Write the sixel sequence drawing \p image to \p ostream with a single
+    /// write, if \p ostream is term formattable
+    void write(std::ostream& ostream, SixelImage const& image);
+
+    /// \Returns the palette of the last encoded image as `0xRRGGBB` values
+    std::span<std::uint32_t const> palette() const;
+
+    /// \Returns the number of images that were encoded with a cached palette
+    std::size_t cacheHits() const { return numCacheHits; }
+
+private:
+    struct Bucket {
+        std::uint16_t key;
+        std::uint32_t count;
+        std::uint64_t red, green, blue;
+    };
+
+    struct Palette {
+        std::uint64_t signature = 0;
+        std::vector<std::uint32_t> colors;
+        /// Palette index of every bucket
+        std::vector<std::uint16_t> lookup;
+    };
+
+    Palette const& quantize(SixelImage const& image);
+    void medianCut(Palette& palette);
+    void appendData(std::size_t width,
+                    std::size_t height,
+                    std::string& out);
+
+    SixelOptions options;
+    /// Slot in `buckets` of every bucket key or -1
+    std::vector<std::int32_t> slots;
+    std::vector<Bucket> buckets;
+    std::vector<Palette> cache;
+    std::size_t nextEvicted = 0;
+    Palette const* current = nullptr;
+    std::size_t numCacheHits = 0;
+    /// Palette index of every pixel or `Transparent`
+    std::vector<std::uint16_t> indices;
+    std::vector<std::uint8_t> bandBits;
+    std::vector<std::int32_t> bandSlots;
+    std::vector<std::uint16_t> bandColors;
+    std::string buffer;
+};
+
+} // namespace tfmt
+
+#endif // TERMFORMAT_SIXEL_H_
@@ -0,0 +1,76 @@
+#ifndef TERMFORMAT_STRING_STREAM_H_
+#define TERMFORMAT_STRING_STREAM_H_
+
+#include <ostream>
+#include <string>
+#include <string_view>
+
+#include <termfmt/api.h>
+
+namespace tfmt {
+
+namespace internal {
+
+class PooledStream;
+
+} // namespace internal
+
+/// String stream taken from a pool of the calling thread
+/// \details Constructing a `std::ostringstream` for every formatted line is
+/// expensive: the stream, its locale and its modifier stack are created and
+/// destroyed every time. Pooled streams are reused instead. They keep the
+/// capacity of their buffer and their modifier stack, and they are ANSI
+/// formattable. The standard format flags, width, precision, fill character,
+/// locale and exception mask, the TFMT format flags and the modifier stack
+/// are restored when a stream is returned to the pool, so nothing leaks from
+/// one use to the next.
+///
+/// \code
+/// tfmt::PooledStringStream stream;
+/// *stream << tfmt::format(tfmt::Bold, "Name: ") << name;
+/// log(stream.view());
+/// \endcode
+class TFMT_API PooledStringStream {
+public:
+    /// Take a stream from the pool or create one if the pool is empty
+    PooledStringStream();
+
+    PooledStringStream(PooledStringStream const&) = delete;
+    PooledStringStream& operator=(PooledStringStream const&) = delete;
+
+    /// Clear the stream and return it to the pool
+    ~PooledStringStream();
+
+    /// \Returns the stream
+    std::ostream& stream();
+
+    /// \overload
+    std::ostream& operator*() { return stream(); }
+
+    /// \overload
+    std::ostream* operator->() { return &stream(); }
+
+    /// \Returns the text written so far. The view is valid until the next
+    /// insertion.
+    std::string_view view() const;
+
+    /// \Returns a copy of the text written so far
+    std::string str() const { return std::string(view()); }
+
+private:
+    internal::PooledStream* impl;
+};
+
+/// \Returns \p objects inserted into a pooled ANSI formattable string stream
+/// \details Use this to format into strings, e.g.
+/// `tfmt::toString(tfmt::format(tfmt::Red, "error"))`.
+template <typename... T>
+std::string toString(T const&... objects) {
+    PooledStringStream stream;
+    (*stream << ... << objects);
+    return stream.str();
+}
+
+} // namespace tfmt
+
+#endif // TERMFORMAT_STRING_STREAM_H_
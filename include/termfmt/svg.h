@@ -0,0 +1,86 @@
+#ifndef TERMFORMAT_SVG_H_
+#define TERMFORMAT_SVG_H_
+
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <string>
+
+#include <termfmt/api.h>
+
+namespace tfmt {
+
+namespace internal {
+
+class SVGRenderer;
+
+} // namespace internal
+
+/// Appearance of documents rendered by `SVGStreambuf`
+struct SVGOptions {
+    /// Font family of the text. Should name a monospace font.
+    std::string fontFamily = "ui-monospace, Menlo, Consolas, monospace";
+
+    /// Font size in pixels
+    double fontSize = 14;
+
+    /// Document background color
+    std::string background = "#1e1e1e";
+
+    /// Default text color
+    std::string foreground = "#e5e5e5";
+};
+
+/// Stream buffer that renders the text written to it as an SVG image
+/// ("terminal screenshot") into a destination stream
+/// \details ANSI format codes in the input are translated to fill, weight,
+/// style and decoration attributes of monospace text runs. Adjacent runs with
+/// the same style are merged. Grapheme clusters occupy the columns counted by
+/// `displayWidth()`, so wide characters take two cells. The document is
+/// written while the input arrives, and only a few kilobytes of the current
+/// text run are held in memory. If the destination stream supports seeking,
+/// the dimensions of the image are patched into the header by `finish()`,
+/// otherwise the image scales to its container.
+class TFMT_API SVGStreambuf: public std::streambuf {
+public:
+    /// Start an SVG document in \p dest
+    explicit SVGStreambuf(std::ostream& dest, SVGOptions options = {});
+
+    SVGStreambuf(SVGStreambuf const&) = delete;
+    SVGStreambuf& operator=(SVGStreambuf const&) = delete;
+
+    /// Calls `finish()`
+    ~SVGStreambuf() override;
+
+    /// Complete the document. Input written after this call is ignored.
+    void finish();
+
+protected:
+    int_type overflow(int_type ch) override;
+
+    std::streamsize xsputn(char const* data, std::streamsize count) override;
+
+    int sync() override;
+
+private:
+    std::unique_ptr<internal::SVGRenderer> renderer;
+};
+
+/// Output stream that renders everything inserted into it as SVG
+/// \details The stream is marked with `setSVGFormattable()`, so modifiers
+/// pushed with `FormatGuard`, `format()` etc. show up in the image.
+class TFMT_API SVGStream: public std::ostream {
+public:
+    /// Start an SVG document in \p dest
+    explicit SVGStream(std::ostream& dest, SVGOptions options = {});
+
+    /// Complete the document. See `SVGStreambuf::finish()`
+    void finish();
+
+private:
+    SVGStreambuf buf;
+};
+
+} // namespace tfmt
+
+#endif // TERMFORMAT_SVG_H_
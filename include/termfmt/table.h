@@ -0,0 +1,121 @@
+#ifndef TERMFORMAT_TABLE_H_
+#define TERMFORMAT_TABLE_H_
+
+#include <cstddef>
+#include <initializer_list>
+#include <iosfwd>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <termfmt/api.h>
+
+namespace tfmt {
+
+class Modifier;
+
+/// Treatment of cells that are wider than the width of their column
+enum class TableOverflow {
+    /// Cut the cell and mark the cut with `…`
+    Truncate,
+    /// Widen the column for this and all following rows
+    Expand,
+};
+
+/// Horizontal alignment of the cells of a column
+enum class TableAlign { Left, Right };
+
+/// Options of `TableWriter`
+struct TableOptions {
+    /// Number of rows that are buffered to determine the column widths
+    std::size_t sampleSize = 100;
+
+    /// Upper bound of the sampled column widths. Zero means unbounded.
+    std::size_t maxColumnWidth = 0;
+
+    /// Upper bound of the total width of a row. If the sampled widths exceed
+    /// it, the widest columns are narrowed. Zero means unbounded. Ignored
+    /// with `TableOverflow::Expand`, which would widen the narrowed columns
+    /// again.
+    std::size_t maxTableWidth = 0;
+
+    /// Alignment of the columns. Columns without an entry are left aligned.
+    std::vector<TableAlign> alignment = {};
+
+    /// Treatment of cells wider than their column after sampling
+    TableOverflow overflow = TableOverflow::Truncate;
+
+    /// Text printed between two columns
+    std::string_view separator = "  ";
+
+    /// Tabs in cells are expanded to stops every `tabWidth` columns from the
+    /// beginning of the cell. Zero leaves tabs in place.
+    std::size_t tabWidth = 8;
+
+    /// Modifier applied to the header row or `nullptr`
+    Modifier const* headerModifier = nullptr;
+};
+
+/// Prints a table with aligned columns while the rows arrive
+/// \details The widths of the columns are measured from the header and the
+/// first `TableOptions::sampleSize` rows, which are held back until the
+/// window is full or `finish()` is called. All following rows are printed
+/// immediately, so the memory usage does not grow with the number of rows.
+/// Widths are measured with `displayWidth()`, so cells may contain ANSI
+/// escape sequences. The number of columns is the number of header cells,
+/// or the largest number of cells in the sampled rows if there is no
+/// header. Missing cells are empty, surplus cells are dropped.
+class TFMT_API TableWriter {
+public:
+    /// Print a table with column titles \p header to \p ostream
+    explicit TableWriter(std::ostream& ostream,
+                         std::vector<std::string> header = {},
+                         TableOptions options = {});
+
+    TableWriter(TableWriter const&) = delete;
+    TableWriter& operator=(TableWriter const&) = delete;
+
+    /// Calls `finish()`
+    ~TableWriter();
+
+    /// Print the row \p cells or add it to the sample window
+    void addRow(std::span<std::string_view const> cells);
+
+    /// \overload
+    void addRow(std::initializer_list<std::string_view> cells) {
+        addRow(std::span(cells.begin(), cells.size()));
+    }
+
+    /// Print the rows of the sample window if it is not full yet
+    void finish();
+
+    /// \Returns the current widths of the columns. Empty until the widths
+    /// have been determined.
+    std::span<std::size_t const> columnWidths() const { return widths; }
+
+private:
+    void layout();
+    void fitToWidth();
+    void putRow(std::span<std::string const> cells, bool isHeader);
+    void putRow(std::span<std::string_view const> cells);
+    void appendCell(std::string_view cell, std::size_t column);
+    void writeLine(bool isHeader);
+    std::span<std::string_view const> expandTabs(
+        std::span<std::string_view const> cells);
+
+    std::ostream& ostream;
+    TableOptions options;
+    std::vector<std::string> header;
+    std::vector<std::vector<std::string>> sample;
+    std::vector<std::size_t> widths;
+    std::string line;
+    std::vector<std::string> expandedCells;
+    std::vector<std::string_view> expandedViews;
+    bool needsReapply = false;
+    bool isLaidOut = false;
+};
+
+} // namespace tfmt
+
+#endif // TERMFORMAT_TABLE_H_
@@ -0,0 +1,110 @@
+#ifndef TERMFORMAT_TABS_H_
+#define TERMFORMAT_TABS_H_
+
+#include <array>
+#include <cstddef>
+#include <ostream>
+#include <span>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <termfmt/api.h>
+
+namespace tfmt {
+
+/// Options of tab expansion
+struct TabOptions {
+    /// Distance of the tab stops after the last entry of `stops`. Must not be
+    /// zero.
+    std::size_t tabWidth = 8;
+
+    /// Columns of the first tab stops in ascending order. `TabExpander`
+    /// copies them, so they may be temporary.
+    std::span<std::size_t const> stops = {};
+};
+
+/// Replaces tabs by spaces up to the next tab stop
+/// \details Text is expanded in chunks, and the column is carried from one
+/// chunk to the next. Line feeds and carriage returns return to column zero.
+/// Columns are counted with `displayWidth()`, so escape sequences occupy no
+/// columns and wide characters two. Runs without tabs are copied as a whole
+/// and only the last line of a run is measured, so text without tabs is
+/// copied at the speed of `memchr()` and `memcpy()`. Lines longer than a few
+/// kilobytes are measured while they arrive, so the unmeasured text that is
+/// kept stays bounded.
+class TFMT_API TabExpander {
+public:
+    explicit TabExpander(TabOptions options = {});
+
+    /// Append \p chunk with all tabs expanded to \p out
+    void expand(std::string_view chunk, std::string& out);
+
+    /// \Returns the column after the text expanded so far
+    std::size_t column() const;
+
+    /// Continue at column zero
+    void reset();
+
+private:
+    std::size_t nextStop(std::size_t column) const;
+    void measurePending();
+    void boundPending();
+
+    std::size_t tabWidth;
+    std::vector<std::size_t> stops;
+    /// Column at the beginning of `pending`
+    std::size_t currentColumn = 0;
+    /// Text of the current line that has been copied but not measured yet
+    std::string pending;
+};
+
+/// \Returns \p text with all tabs expanded as by `TabExpander`
+TFMT_API std::string expandTabs(std::string_view text,
+                                TabOptions const& options = {});
+
+/// Stream buffer that expands tabs and writes the result to another stream
+class TFMT_API TabStreambuf: public std::streambuf {
+public:
+    /// Write the expanded text to \p dest
+    explicit TabStreambuf(std::ostream& dest, TabOptions options = {});
+
+    TabStreambuf(TabStreambuf const&) = delete;
+    TabStreambuf& operator=(TabStreambuf const&) = delete;
+
+    /// Writes the buffered text
+    ~TabStreambuf() override;
+
+protected:
+    int_type overflow(int_type ch) override;
+
+    std::streamsize xsputn(char const* data, std::streamsize count) override;
+
+    int sync() override;
+
+private:
+    void write(std::string_view text);
+    void drain();
+
+    std::ostream& dest;
+    TabExpander expander;
+    std::string expanded;
+    std::array<char, 4096> buffer;
+};
+
+/// Output stream that expands tabs and writes the result to another stream
+/// \details The format flags of the destination stream are copied, so
+/// modifiers are emitted if the destination is term formattable.
+class TFMT_API TabStream: public std::ostream {
+public:
+    /// Write the expanded text to \p dest
+    explicit TabStream(std::ostream& dest, TabOptions options = {});
+
+private:
+    TabStreambuf buf;
+};
+
+} // namespace tfmt
+
+#endif // TERMFORMAT_TABS_H_
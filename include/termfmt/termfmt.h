@@ -2,6 +2,7 @@
 #define TERMFORMAT_H_
 
 #include <concepts>
+#include <cstdint>
 #include <functional>
 #include <iosfwd>
 #include <optional>
@@ -30,6 +31,10 @@ template <typename... T>
 class ObjectWrapper;
 template <typename CharT, typename Traits>
 class OStreamWrapper;
+template <typename T>
+class StyledRef;
+template <typename CharT, typename Traits>
+class ModifierRefGuard;
 
 template <typename T, typename CharT, typename Traits>
 concept Printable =
@@ -90,11 +95,40 @@ template <typename CharT, typename Traits>
 TFMT_API bool isHTMLFormattable(
     std::basic_ostream<CharT, Traits> const& ostream);
 
+/// Set or unset \p ostream to be an SVG stream.
+/// \details Modifiers inserted into SVG streams emit ANSI format codes that
+/// are translated to SVG by the stream buffer. This is set up by
+/// `tfmt::SVGStream` and usually does not need to be called directly.
+template <typename CharT, typename Traits>
+TFMT_API void setSVGFormattable(std::basic_ostream<CharT, Traits>& ostream,
+                                bool value = true);
+
+/// Query whether \p ostream has been marked as an SVG stream with a call to
+/// `setSVGFormattable()`
+template <typename CharT, typename Traits>
+TFMT_API bool isSVGFormattable(
+    std::basic_ostream<CharT, Traits> const& ostream);
+
 /// Copies all TFMT format flags from \p source to \p dest
 template <typename CharT, typename Traits>
 TFMT_API void copyFormatFlags(std::basic_ostream<CharT, Traits> const& source,
                               std::basic_ostream<CharT, Traits>& dest);
 
+/// \Returns the number of terminal columns occupied by \p text
+/// \details ANSI escape sequences and control characters occupy no columns.
+/// The text is measured by grapheme clusters as segmented by
+/// `nextGrapheme()`: combining marks and other zero width characters add
+/// nothing, East Asian wide characters, flags and emoji occupy two columns
+/// and all other clusters one.
+TFMT_API size_t displayWidth(std::string_view text);
+
+/// \Returns the longest prefix of \p text that occupies at most \p width
+/// columns as counted by `displayWidth()`
+/// \details Escape sequences and grapheme clusters are never split, so a
+/// wide character that would only fit halfway is left out. Escape sequences
+/// directly following the last visible character are part of the prefix.
+TFMT_API std::string_view truncateToWidth(std::string_view text, size_t width);
+
 /// Combine modifiers \p lhs and \p rhs
 TFMT_API Modifier operator|(Modifier const& rhs, Modifier const& lhs);
 
@@ -117,6 +151,13 @@ TFMT_API void pushModifier(Modifier mod,
 /// Push modifier to `stdout`.
 TFMT_API void pushModifier(Modifier);
 
+/// Push a reference to \p mod to \p ostream .
+/// \details Like `pushModifier()` but the modifier is not copied. \p mod must
+/// stay alive until it is popped with `popModifier()`.
+template <typename CharT, typename Traits>
+TFMT_API void pushModifierRef(Modifier const& mod,
+                              std::basic_ostream<CharT, Traits>& ostream);
+
 /// Pop a modifier from \p ostream .
 template <typename CharT, typename Traits>
 TFMT_API void popModifier(std::basic_ostream<CharT, Traits>& ostream);
@@ -182,6 +223,29 @@ template <typename CharT, typename Traits>
 TFMT_API internal::OStreamWrapper<CharT, Traits> format(
     Modifier mod, std::basic_ostream<CharT, Traits>& ostream);
 
+/// Customization point assigning a style to values of type `T`
+/// \details Either specialize this template with a static member function
+/// `Modifier const& modifier(T const&)`, or declare a function
+/// `Modifier const& tfmt_style(T const&)` in the namespace of `T` to be found
+/// by argument dependent lookup. The returned modifier must outlive the
+/// insertion, usually it has static storage duration.
+template <typename T>
+struct StyleTraits;
+
+/// Satisfied by types with a style assigned via `StyleTraits`
+template <typename T>
+concept Styleable = requires(T const& value) {
+    { StyleTraits<T>::modifier(value) } -> std::same_as<Modifier const&>;
+};
+
+/// Insert \p value styled with the modifier assigned by `StyleTraits<T>`
+/// \details The returned object only refers to \p value . The style is
+/// selected by overload resolution at compile time and its modifier is pushed
+/// by reference, so no modifier is copied and no wrapper owns a copy of
+/// \p value .
+template <Styleable T>
+internal::StyledRef<T> styled(T const& value);
+
 /// Type erased class giving a unified interface for the return types of the
 /// `format(Modifier mod, T&&... objects)` functions.
 template <typename CharT, typename Traits>
@@ -254,18 +318,143 @@ TFMT_API extern Modifier const BGBrightWhite;
 // === Inline implementation -------------------------------===
 // ===------------------------------------------------------===
 
+namespace tfmt::internal {
+
+/// Marks text that was cut to fit into a column
+inline constexpr std::string_view Ellipsis = "…";
+
+/// SGR attributes set by a modifier or in effect on a stream
+struct Attributes {
+    enum Flag : std::uint16_t {
+        Bold = 1 << 0,
+        Dim = 1 << 1,
+        Italic = 1 << 2,
+        Underline = 1 << 3,
+        Blink = 1 << 4,
+        Inverse = 1 << 5,
+        Concealed = 1 << 6,
+        Crossed = 1 << 7,
+    };
+
+    /// Color kinds, stored in the upper 8 bits of `fg` and `bg`
+    enum ColorKind : std::uint32_t {
+        /// The terminal default color. The whole value is zero.
+        DefaultColor = 0,
+        /// One of the 16 basic colors. The lower bits hold the SGR code, e.g.
+        /// 31 for red foreground or 104 for bright blue background.
+        BasicColor = 1,
+        /// Index into the 256 color palette
+        IndexedColor = 2,
+        /// 24 bit RGB color `0xRRGGBB`
+        RGBColor = 3,
+    };
+
+    static constexpr std::uint32_t makeColor(ColorKind kind,
+                                             std::uint32_t value) {
+        return kind << 24 | (value & 0xFFFFFF);
+    }
+
+    static constexpr ColorKind colorKind(std::uint32_t color) {
+        return ColorKind(color >> 24);
+    }
+
+    /// Set of `Flag`s
+    std::uint16_t flags = 0;
+
+    /// `true` if all attributes are reset before applying this set
+    bool reset = false;
+
+    std::uint32_t fg = DefaultColor;
+    std::uint32_t bg = DefaultColor;
+
+    bool operator==(Attributes const&) const = default;
+
+    /// \Returns attributes that reset everything
+    static constexpr Attributes makeReset() {
+        Attributes result;
+        result.reset = true;
+        return result;
+    }
+};
+
+/// \Returns the attributes in effect after applying \p mod on top of \p base
+constexpr Attributes combine(Attributes base, Attributes const& mod) {
+    if (mod.reset) {
+        base = Attributes::makeReset();
+    }
+    base.flags |= mod.flags;
+    if (mod.fg != Attributes::DefaultColor) {
+        base.fg = mod.fg;
+    }
+    if (mod.bg != Attributes::DefaultColor) {
+        base.bg = mod.bg;
+    }
+    return base;
+}
+
+/// Apply the parameters \p params of one SGR sequence to \p attribs
+/// \details Bit `i` of \p subparams is set if `params[i]` follows a `:`, as
+/// in `AnsiEvent::subparams`. The colon forms `38:5:n`, `38:2::r:g:b`,
+/// `38:2:r:g:b`, the same for 48, and `4:0` and `4:1` are understood. Other
+/// groups of subparameters are skipped as a whole, so their values are not
+/// mistaken for other codes.
+/// \Returns `true` if the sequence sets attributes after its last reset that
+/// `Attributes` doesn't track, e.g. overlines, underline styles and colors or
+/// codes that are not known at all
+TFMT_API bool applySGR(Attributes& attribs,
+                       std::span<unsigned const> params,
+                       std::uint32_t subparams = 0);
+
+/// \Returns the attributes set by the ANSI SGR sequences in \p ansi when
+/// applied on top of \p base
+TFMT_API Attributes parseAttributes(std::string_view ansi,
+                                    Attributes base = {});
+
+/// \Returns `true` if the ANSI SGR sequences in \p ansi leave attributes set
+/// that `Attributes` doesn't track, e.g. an overline, as reported by
+/// `applySGR()`
+TFMT_API bool setsUntracked(std::string_view ansi);
+
+/// Append the shortest SGR sequence that changes the attributes in effect
+/// from \p from to \p to to \p out
+/// \details Attributes that are set in \p from but not in \p to are
+/// undone with their targeted off codes (22 for bold and dim, 23 for italic,
+/// 39 for the default foreground etc.) instead of a full reset. Nothing is
+/// appended if the attributes are equal.
+TFMT_API void appendTransition(Attributes const& from,
+                               Attributes const& to,
+                               std::string& out);
+
+/// \Returns the attributes in effect on \p ostream according to its stack of
+/// modifiers
+template <typename CharT, typename Traits>
+TFMT_API Attributes currentAttributes(
+    std::basic_ostream<CharT, Traits> const& ostream);
+
+/// Remove all modifiers from the stack of \p ostream without writing the
+/// codes that undo them
+template <typename CharT, typename Traits>
+TFMT_API void clearModifiers(std::basic_ostream<CharT, Traits>& ostream);
+
+} // namespace tfmt::internal
+
 class tfmt::internal::ModBase {
 public:
     enum class ResetTag {};
 
 public:
     explicit ModBase(std::string_view ansiMod, ResetTag):
-        ansiBuf(ansiMod), isReset(true) {}
+        ansiBuf(ansiMod), attribs(Attributes::makeReset()), isReset(true) {}
     explicit ModBase(std::string_view ansiMod, std::string htmlMod):
         ModBase(ansiMod, std::vector{ htmlMod }) {}
     explicit ModBase(std::string_view ansiMod,
                      std::vector<std::string> htmlMod):
-        ansiBuf(ansiMod), htmlBuf(htmlMod) {}
+        ansiBuf(ansiMod),
+        htmlBuf(htmlMod),
+        attribs(parseAttributes(ansiMod)),
+        untracked(setsUntracked(ansiMod)) {
+        updateOffBuffer();
+    }
 
     template <typename CharT, typename Traits>
     friend std::basic_ostream<CharT, Traits>& operator<<(
@@ -277,16 +466,43 @@ public:
     /// \Returns the ANSI codes representing this modifier
     std::string_view ansiBuffer() const { return ansiBuf; }
 
+    /// \Returns the ANSI codes that undo this modifier on an otherwise
+    /// unformatted stream
+    std::string_view ansiOffBuffer() const { return ansiOffBuf; }
+
     /// \Returns the list of HTML tags representing this modifier
-    std::span<std::string const> htmlBuffer() { return htmlBuf; }
+    std::span<std::string const> htmlBuffer() const { return htmlBuf; }
+
+    /// \Returns the SGR attributes this modifier sets
+    Attributes const& attributes() const { return attribs; }
+
+    /// \Returns `true` if this is the `Reset` modifier
+    bool isResetModifier() const { return isReset; }
+
+    /// \Returns `true` if the ANSI codes of this modifier set attributes that
+    /// `attributes()` doesn't track, e.g. an overline. Only a reset undoes
+    /// them.
+    bool hasUntrackedCodes() const { return untracked; }
 
 private:
     template <typename CharT, typename Traits>
     void put(std::basic_ostream<CharT, Traits>& ostream) const;
 
 protected:
+    void updateOffBuffer() {
+        ansiOffBuf.clear();
+        if (untracked) {
+            ansiOffBuf = "\033[0m";
+            return;
+        }
+        appendTransition(attribs, {}, ansiOffBuf);
+    }
+
     std::string ansiBuf;
+    std::string ansiOffBuf;
     std::vector<std::string> htmlBuf;
+    Attributes attribs;
+    bool untracked = false;
     bool isReset = false;
 };
 
@@ -307,6 +523,10 @@ inline tfmt::Modifier tfmt::operator|(Modifier const& lhs,
 
 inline tfmt::Modifier tfmt::operator|(Modifier&& lhs, Modifier const& rhs) {
     lhs.ansiBuf += rhs.ansiBuf;
+    lhs.attribs = internal::combine(lhs.attribs, rhs.attribs);
+    // A reset in `rhs` undoes the untracked attributes of `lhs`
+    lhs.untracked = rhs.untracked || (lhs.untracked && !rhs.attribs.reset);
+    lhs.updateOffBuffer();
     lhs.htmlBuf.insert(lhs.htmlBuf.end(),
                        rhs.htmlBuf.begin(),
                        rhs.htmlBuf.end());
@@ -330,6 +550,25 @@ void tfmt::formatScope(Modifier mod, std::invocable auto&& fn) {
     std::invoke(fn);
 }
 
+/// Pushes a modifier by reference for the lifetime of the guard
+template <typename CharT, typename Traits>
+class tfmt::internal::ModifierRefGuard {
+public:
+    explicit ModifierRefGuard(Modifier const& mod,
+                              std::basic_ostream<CharT, Traits>& ostream):
+        ostream(ostream) {
+        pushModifierRef(mod, ostream);
+    }
+
+    ModifierRefGuard(ModifierRefGuard const&) = delete;
+    ModifierRefGuard& operator=(ModifierRefGuard const&) = delete;
+
+    ~ModifierRefGuard() { popModifier(ostream); }
+
+private:
+    std::basic_ostream<CharT, Traits>& ostream;
+};
+
 template <typename... T>
 class tfmt::internal::ObjectWrapper {
 public:
@@ -341,7 +580,7 @@ public:
     friend std::basic_ostream<CharT, Traits>& operator<<(
         std::basic_ostream<CharT, Traits>& ostream,
         ObjectWrapper const& wrapper) {
-        FormatGuard fmt(wrapper.mod, ostream);
+        ModifierRefGuard fmt(wrapper.mod, ostream);
         [&]<std::size_t... I>(std::index_sequence<I...>) {
             ((ostream << std::get<I>(wrapper.objects)), ...);
         }(std::index_sequence_for<T...>{});
@@ -359,6 +598,47 @@ tfmt::internal::ObjectWrapper<T...> tfmt::format(Modifier mod, T&&... objects) {
                                          std::forward<T>(objects)...);
 }
 
+namespace tfmt::internal {
+
+template <typename T>
+concept HasStyleHook = requires(T const& value) {
+    { tfmt_style(value) } -> std::same_as<Modifier const&>;
+};
+
+} // namespace tfmt::internal
+
+template <typename T>
+struct tfmt::StyleTraits {
+    static Modifier const& modifier(T const& value)
+        requires internal::HasStyleHook<T>
+    {
+        return tfmt_style(value);
+    }
+};
+
+template <typename T>
+class tfmt::internal::StyledRef {
+public:
+    explicit StyledRef(T const& value): value(value) {}
+
+    template <typename CharT, typename Traits>
+        requires Printable<T, CharT, Traits>
+    friend std::basic_ostream<CharT, Traits>& operator<<(
+        std::basic_ostream<CharT, Traits>& ostream, StyledRef const& ref) {
+        ModifierRefGuard guard(StyleTraits<T>::modifier(ref.value), ostream);
+        ostream << ref.value;
+        return ostream;
+    }
+
+private:
+    T const& value;
+};
+
+template <tfmt::Styleable T>
+tfmt::internal::StyledRef<T> tfmt::styled(T const& value) {
+    return internal::StyledRef<T>(value);
+}
+
 template <typename CharT, typename Traits>
 class tfmt::BasicVObjectWrapper {
     struct Tag {};
@@ -399,7 +679,7 @@ public:
     template <Printable<CharT, Traits> T>
     friend OStreamWrapper<CharT, Traits>& operator<<(
         OStreamWrapper<CharT, Traits>& wrapper, T const& object) {
-        FormatGuard fmt(wrapper.mod, wrapper.ostream);
+        ModifierRefGuard fmt(wrapper.mod, wrapper.ostream);
         wrapper.ostream << object;
         return wrapper;
     }
@@ -0,0 +1,67 @@
+#ifndef TERMFORMAT_WRAP_H_
+#define TERMFORMAT_WRAP_H_
+
+#include <cstddef>
+#include <iosfwd>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include <termfmt/api.h>
+
+namespace tfmt {
+
+/// Line breaking algorithm of `wrap()`
+enum class WrapMode {
+    /// Put as many words on a line as fit. Fast, but can leave some lines
+    /// much shorter than others.
+    Greedy,
+
+    /// Choose the breaks that minimize the sum of the squared free columns
+    /// of all lines but the last of a paragraph, like Knuth and Plass
+    Optimal,
+};
+
+/// Options of `wrap()`
+struct WrapOptions {
+    /// Number of columns including the indentation. If not set, the width of
+    /// the stream as returned by `getWidth()` is used, or 80 if there is no
+    /// stream or it has no width.
+    std::optional<std::size_t> width;
+
+    /// Line breaking algorithm
+    WrapMode mode = WrapMode::Greedy;
+
+    /// Number of spaces printed before every line
+    std::size_t indent = 0;
+
+    /// Distribute the free columns of all lines but the last of a paragraph
+    /// over the gaps between their words, so both margins are straight
+    bool justify = false;
+};
+
+/// \Returns \p text with line breaks inserted so no line is wider than
+/// `options.width`
+/// \details Words are separated by spaces and tabs, and runs of them
+/// collapse into one space. Line breaks in \p text are kept, so every line
+/// of \p text is wrapped as a separate paragraph. Words wider than a line get
+/// a line of their own and are not split. Widths are measured with
+/// `displayWidth()`, so \p text may contain ANSI escape sequences. SGR
+/// attributes that are in effect at a line break are undone before the break
+/// and restored after the indentation, so every line can be printed on its
+/// own.
+///
+/// `WrapMode::Optimal` only considers the breaks of the words that fit on
+/// one line, so it takes time linear in the length of \p text for a fixed
+/// width.
+TFMT_API std::string wrap(std::string_view text,
+                          WrapOptions const& options = {});
+
+/// Print \p text wrapped as by `wrap()` to \p ostream
+TFMT_API void wrap(std::ostream& ostream,
+                   std::string_view text,
+                   WrapOptions const& options = {});
+
+} // namespace tfmt
+
+#endif // TERMFORMAT_WRAP_H_
@@ -0,0 +1,173 @@
+#!/usr/bin/env python3
+"""Generate src/unicode_tables.h from the Unicode Character Database.
+
+Usage: generate_unicode_tables.py <UCD directory> <Unicode version>
+
+The UCD directory must contain GraphemeBreakProperty.txt, emoji-data.txt,
+EastAsianWidth.txt and DerivedGeneralCategory.txt, e.g. extracted from
+https://www.unicode.org/Public/<version>/ucd/UCD.zip.
+
+Every code point gets one byte: the grapheme cluster break property in the
+lower four bits and the display width class in the upper bits. The bytes are
+stored in a two-level table: the upper bits of a code point select a block,
+and identical blocks are stored only once.
+"""
+
+import os
+import re
+import sys
+
+MAX_CODE_POINT = 0x10FFFF
+
+# Must match enum GraphemeBreak in src/grapheme.cpp
+BREAK_PROPERTIES = [
+    "Other", "CR", "LF", "Control", "Extend", "ZWJ", "Regional_Indicator",
+    "Prepend", "SpacingMark", "L", "V", "T", "LV", "LVT",
+    "Extended_Pictographic",
+]
+
+# Width classes, stored shifted left by WIDTH_SHIFT
+WIDTH_ZERO, WIDTH_ONE, WIDTH_TWO = 0, 1, 2
+WIDTH_SHIFT = 4
+
+LINE = re.compile(r"^([0-9A-F]+)(?:\.\.([0-9A-F]+))?\s*;\s*(\w+)")
+
+
+def parse(path, wanted=None):
+    """Yield (first, last, value) of the ranges in the UCD file at path"""
+    with open(path, encoding="utf-8") as file:
+        for line in file:
+            match = LINE.match(line)
+            if not match:
+                continue
+            first = int(match.group(1), 16)
+            last = int(match.group(2) or match.group(1), 16)
+            value = match.group(3)
+            if wanted is None or value in wanted:
+                yield first, last, value
+
+
+def build(ucd):
+    breaks = [0] * (MAX_CODE_POINT + 1)
+    for first, last, value in parse(
+            os.path.join(ucd, "GraphemeBreakProperty.txt")):
+        index = BREAK_PROPERTIES.index(value)
+        breaks[first:last + 1] = [index] * (last - first + 1)
+    # Extended_Pictographic never overlaps with the break properties above
+    pictographic = BREAK_PROPERTIES.index("Extended_Pictographic")
+    for first, last, _ in parse(os.path.join(ucd, "emoji-data.txt"),
+                                {"Extended_Pictographic"}):
+        for cp in range(first, last + 1):
+            if breaks[cp] == 0:
+                breaks[cp] = pictographic
+
+    widths = [WIDTH_ONE] * (MAX_CODE_POINT + 1)
+    for first, last, _ in parse(os.path.join(ucd, "EastAsianWidth.txt"),
+                                {"W", "F"}):
+        widths[first:last + 1] = [WIDTH_TWO] * (last - first + 1)
+    # Marks, format and control characters occupy no columns. Unassigned
+    # code points keep the width of their block.
+    for first, last, _ in parse(
+            os.path.join(ucd, "DerivedGeneralCategory.txt"),
+            {"Mn", "Me", "Cf", "Cc"}):
+        widths[first:last + 1] = [WIDTH_ZERO] * (last - first + 1)
+    # Medial vowels and final consonants of Hangul syllables attach to the
+    # leading consonant
+    for cp in range(0x1160, 0x1200):
+        widths[cp] = WIDTH_ZERO
+    for cp in range(0xD7B0, 0xD800):
+        widths[cp] = WIDTH_ZERO
+
+    return [b | w << WIDTH_SHIFT for b, w in zip(breaks, widths)]
+
+
+def compress(properties, shift):
+    """Split properties into deduplicated blocks of 1 << shift entries"""
+    size = 1 << shift
+    default = properties[-1]
+    # Trailing blocks equal to the default are not stored
+    end = len(properties)
+    while end > 0 and properties[end - 1] == default:
+        end -= 1
+    end = (end + size - 1) // size * size
+    blocks = {}
+    index = []
+    data = []
+    for start in range(0, end, size):
+        block = tuple(properties[start:start + size])
+        if block not in blocks:
+            blocks[block] = len(blocks)
+            data.extend(block)
+        index.append(blocks[block])
+    return index, data, default
+
+
+def table_size(index, data):
+    entry = 1 if max(index) < 256 else 2
+    return len(index) * entry + len(data)
+
+
+def format_array(values, indent="    ", width=80):
+    lines = []
+    line = indent
+    for value in values:
+        item = f"{value},"
+        if len(line) + len(item) + 1 > width:
+            lines.append(line.rstrip())
+            line = indent
+        line += item + " "
+    lines.append(line.rstrip())
+    return "\n".join(lines)
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit(__doc__)
+    ucd, version = sys.argv[1], sys.argv[2]
+    properties = build(ucd)
+    shift = min(range(4, 12),
+                key=lambda s: table_size(*compress(properties, s)[:2]))
+    index, data, default = compress(properties, shift)
+    index_type = "std::uint8_t" if max(index) < 256 else "std::uint16_t"
+    output = os.path.join(os.path.dirname(__file__), "..", "src",
+                          "unicode_tables.h")
+    with open(output, "w", encoding="utf-8") as file:
+        file.write(f"""\
+// Generated by scripts/generate_unicode_tables.py from Unicode {version}.
+// Do not edit.
+
+#ifndef TERMFORMAT_UNICODE_TABLES_H_
+#define TERMFORMAT_UNICODE_TABLES_H_
+
+#include <cstdint>
+
+namespace tfmt::internal::unicode {{
+
+/// Number of low bits of a code point that index into a block
+inline constexpr unsigned BlockShift = {shift};
+
+/// Number of code points covered by `BlockIndex`. All code points above have
+/// the properties `DefaultProperties`.
+inline constexpr std::uint32_t TableEnd = {len(index) << shift:#x};
+
+inline constexpr std::uint8_t DefaultProperties = {default};
+
+/// Index of the block of every `1 << BlockShift` code points
+inline constexpr {index_type} BlockIndex[] = {{
+{format_array(index)}
+}};
+
+/// Properties of the code points of every block. The lower four bits hold the
+/// grapheme cluster break property, the upper bits the width class.
+inline constexpr std::uint8_t Blocks[] = {{
+{format_array(data)}
+}};
+
+}} // namespace tfmt::internal::unicode
+
+#endif // TERMFORMAT_UNICODE_TABLES_H_
+""")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,199 @@
+#include "termfmt/animation.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+
+#include "termfmt/termfmt.h"
+
+using namespace tfmt;
+
+AnimationScheduler::AnimationScheduler(std::ostream& ostream,
+                                       std::chrono::milliseconds tick):
+    out(&ostream), tick(std::max(tick, std::chrono::milliseconds(1))) {}
+
+AnimationScheduler::~AnimationScheduler() {
+    {
+        std::lock_guard lock(mutex);
+        assert(numActive == 0 && "Animations must be stopped before");
+        stopping = true;
+    }
+    cv.notify_all();
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+AnimationScheduler& AnimationScheduler::global() {
+    static AnimationScheduler scheduler(std::cout);
+    return scheduler;
+}
+
+void AnimationScheduler::add(Animation& animation) {
+    {
+        std::lock_guard lock(mutex);
+        // The first frame is drawn with the next tick
+        schedule(animation, 1);
+        ++numActive;
+        if (!thread.joinable()) {
+            thread = std::thread([this] { run(); });
+        }
+    }
+    cv.notify_all();
+}
+
+void AnimationScheduler::remove(Animation& animation,
+                                std::string_view epilogue) {
+    std::lock_guard lock(mutex);
+    auto& timers = wheel[animation.slot];
+    auto itr = std::find_if(timers.begin(), timers.end(), [&](Timer timer) {
+        return timer.animation == &animation;
+    });
+    assert(itr != timers.end());
+    timers.erase(itr);
+    --numActive;
+    if (!epilogue.empty()) {
+        out->write(epilogue.data(),
+                   static_cast<std::streamsize>(epilogue.size()));
+        out->flush();
+        counters.bytesWritten += epilogue.size();
+    }
+}
+
+AnimationStats AnimationScheduler::stats() const {
+    std::lock_guard lock(mutex);
+    return counters;
+}
+
+void AnimationScheduler::schedule(Animation& animation, std::size_t ticks) {
+    // The slot is visited again after `ticks` steps if `ticks` is not a
+    // multiple of the wheel size and otherwise after a full turn
+    animation.slot = (cursor + ticks) % NumSlots;
+    wheel[animation.slot].push_back({ &animation, (ticks - 1) / NumSlots });
+}
+
+void AnimationScheduler::run() {
+    std::unique_lock lock(mutex);
+    auto next = std::chrono::steady_clock::now() + tick;
+    while (!stopping) {
+        if (numActive == 0) {
+            cv.wait(lock, [&] { return stopping || numActive > 0; });
+            next = std::chrono::steady_clock::now() + tick;
+            continue;
+        }
+        if (cv.wait_until(lock, next, [&] { return stopping; })) {
+            break;
+        }
+        advance();
+        if (!buffer.empty()) {
+            out->write(buffer.data(),
+                       static_cast<std::streamsize>(buffer.size()));
+            out->flush();
+            counters.bytesWritten += buffer.size();
+            buffer.clear();
+        }
+        // If we fall behind we don't try to catch up, late frames are
+        // useless
+        next = std::max(next + tick, std::chrono::steady_clock::now());
+    }
+}
+
+void AnimationScheduler::advance() {
+    cursor = (cursor + 1) % NumSlots;
+    auto& timers = wheel[cursor];
+    // Collect the due timers first, rescheduling may append to this slot
+    std::erase_if(timers, [&](Timer& timer) {
+        if (timer.rounds > 0) {
+            --timer.rounds;
+            return false;
+        }
+        due.push_back(timer.animation);
+        return true;
+    });
+    for (Animation* animation: due) {
+        std::string_view const frame = animation->nextFrame();
+        ++counters.frames;
+        // Frames are complete draw sequences, so equal bytes draw the same
+        if (frame == animation->drawnFrame) {
+            ++counters.suppressedFrames;
+            counters.bytesSuppressed += frame.size();
+        }
+        else {
+            buffer += frame;
+            animation->drawnFrame = frame;
+        }
+        schedule(*animation, animation->intervalTicks);
+    }
+    due.clear();
+}
+
+/// Appends the codes that save the cursor and move it to the position of an
+/// animation
+static void appendMoveTo(std::string& str, AnimationOptions const& options) {
+    str += "\0337";
+    if (options.row > 0) {
+        str += "\033[" + std::to_string(options.row) + "A";
+    }
+    str += "\r";
+    if (options.column > 0) {
+        str += "\033[" + std::to_string(options.column) + "C";
+    }
+}
+
+static void appendRestore(std::string& str) { str += "\0338"; }
+
+Animation::Animation(std::span<std::string_view const> frameTexts,
+                     Modifier const& mod,
+                     AnimationOptions options,
+                     AnimationScheduler& scheduler):
+    scheduler(scheduler) {
+    auto const tick = scheduler.tick.count();
+    auto const ticks = (options.interval.count() + tick / 2) / tick;
+    intervalTicks = static_cast<std::size_t>(std::max<std::int64_t>(1, ticks));
+    std::size_t maxWidth = 0;
+    frames.reserve(frameTexts.size());
+    for (auto text: frameTexts) {
+        auto& frame = frames.emplace_back();
+        appendMoveTo(frame, options);
+        frame += mod.ansiBuffer();
+        frame += text;
+        frame += mod.ansiOffBuffer();
+        appendRestore(frame);
+        maxWidth = std::max(maxWidth, displayWidth(text));
+    }
+    if (options.clearOnStop) {
+        appendMoveTo(clearSequence, options);
+        clearSequence.append(maxWidth, ' ');
+        appendRestore(clearSequence);
+    }
+    if (frames.empty() || !isTermFormattable(scheduler.ostream())) {
+        return;
+    }
+    running = true;
+    scheduler.add(*this);
+}
+
+Animation::~Animation() { stop(); }
+
+void Animation::stop() {
+    if (!running) {
+        return;
+    }
+    running = false;
+    scheduler.remove(*this, clearSequence);
+}
+
+std::string_view Animation::nextFrame() {
+    std::string_view frame = frames[frameIndex];
+    frameIndex = (frameIndex + 1) % frames.size();
+    return frame;
+}
+
+static constexpr std::string_view SpinnerFrames[] = {
+    "⠋", "⠙", "⠹", "⠸", "⠼", "⠴", "⠦", "⠧", "⠇", "⠏",
+};
+
+Spinner::Spinner(Modifier const& mod,
+                 AnimationOptions options,
+                 AnimationScheduler& scheduler):
+    Animation(SpinnerFrames, mod, options, scheduler) {}
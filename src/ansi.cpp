@@ -0,0 +1,279 @@
+#include "termfmt/ansi.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define TFMT_ANSI_SSE2 1
+#else
+#define TFMT_ANSI_SSE2 0
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define TFMT_ANSI_NEON 1
+#else
+#define TFMT_ANSI_NEON 0
+#endif
+
+using namespace tfmt;
+
+static constexpr char Escape = '\033';
+
+static bool isControl(char c) {
+    auto const uc = static_cast<unsigned char>(c);
+    return uc < 0x20 || uc == 0x7F;
+}
+
+/// \Returns the offset of the first control character in \p text at or
+/// after \p pos , or `text.size()`
+static std::size_t findControl(std::string_view text, std::size_t pos) {
+    char const* const data = text.data();
+    std::size_t const size = text.size();
+#if TFMT_ANSI_SSE2
+    __m128i const maxControl = _mm_set1_epi8(0x1F);
+    __m128i const del = _mm_set1_epi8(0x7F);
+    for (; pos + 16 <= size; pos += 16) {
+        __m128i const block =
+            _mm_loadu_si128(reinterpret_cast<__m128i const*>(data + pos));
+        // Unsigned comparison: block <= 0x1F iff min(block, 0x1F) == block
+        __m128i const matches = _mm_or_si128(
+            _mm_cmpeq_epi8(_mm_min_epu8(block, maxControl), block),
+            _mm_cmpeq_epi8(block, del));
+        if (int const mask = _mm_movemask_epi8(matches)) {
+#if defined(_MSC_VER)
+            unsigned long index;
+            _BitScanForward(&index, static_cast<unsigned long>(mask));
+            return pos + index;
+#else
+            return pos + static_cast<std::size_t>(
+                             __builtin_ctz(static_cast<unsigned>(mask)));
+#endif
+        }
+    }
+#elif TFMT_ANSI_NEON
+    uint8x16_t const space = vdupq_n_u8(0x20);
+    uint8x16_t const del = vdupq_n_u8(0x7F);
+    for (; pos + 16 <= size; pos += 16) {
+        uint8x16_t const block =
+            vld1q_u8(reinterpret_cast<std::uint8_t const*>(data + pos));
+        uint8x16_t const matches =
+            vorrq_u8(vcltq_u8(block, space), vceqq_u8(block, del));
+        if (vmaxvq_u8(matches) != 0) {
+            break;
+        }
+    }
+#endif
+    for (; pos < size; ++pos) {
+        if (isControl(data[pos])) {
+            return pos;
+        }
+    }
+    return size;
+}
+
+void AnsiParser::feed(std::string_view newChunk) {
+    chunk = newChunk;
+    pos = 0;
+    sequenceBegin = 0;
+}
+
+void AnsiParser::reset() {
+    state = State::Ground;
+    buffered = false;
+    bufferSize = 0;
+}
+
+std::optional<AnsiEvent> AnsiParser::next() {
+    while (true) {
+        if (state != State::Ground) {
+            if (auto event = parseSequence()) {
+                return event;
+            }
+            if (state != State::Ground) {
+                // The chunk ends within the sequence
+                return std::nullopt;
+            }
+            continue;
+        }
+        if (pos == chunk.size()) {
+            return std::nullopt;
+        }
+        char const c = chunk[pos];
+        if (c == Escape) {
+            state = State::Escape;
+            sequenceBegin = ++pos;
+            buffered = false;
+            bufferSize = 0;
+            continue;
+        }
+        if (isControl(c)) {
+            return AnsiEvent{ .kind = AnsiEventKind::Control,
+                              .text = chunk.substr(pos++, 1),
+                              .final = c };
+        }
+        std::size_t const end = findControl(chunk, pos + 1);
+        auto const text = chunk.substr(pos, end - pos);
+        pos = end;
+        return AnsiEvent{ .kind = AnsiEventKind::Text, .text = text };
+    }
+}
+
+std::optional<AnsiEvent> AnsiParser::parseSequence() {
+    // The body of the sequence starts at `pos`
+    auto beginBody = [&] {
+        sequenceBegin = pos;
+        buffered = false;
+        bufferSize = 0;
+    };
+    // Restart with the escape character at `pos - 1`, which cancels the
+    // current sequence
+    auto restart = [&] {
+        state = State::Escape;
+        beginBody();
+    };
+    while (pos < chunk.size()) {
+        char const c = chunk[pos++];
+        switch (state) {
+        case State::Ground:
+            break;
+        case State::Escape:
+            switch (c) {
+            case '[':
+                state = State::CSI;
+                beginBody();
+                break;
+            case ']':
+            case 'P':
+            case 'X':
+            case '^':
+            case '_':
+                state = State::String;
+                introducer = c;
+                beginBody();
+                break;
+            case Escape:
+                restart();
+                break;
+            default:
+                // Intermediate bytes are followed by the final byte
+                if (c >= 0x20 && c <= 0x2F) {
+                    break;
+                }
+                return finishSequence(AnsiEventKind::Escape, c, pos - 1);
+            }
+            break;
+        case State::CSI:
+            if (c >= 0x40 && c <= 0x7E) {
+                return finishSequence(AnsiEventKind::CSI, c, pos - 1);
+            }
+            if (c == Escape) {
+                restart();
+            }
+            break;
+        case State::String: {
+            // Skip to the terminator
+            std::size_t end = pos - 1;
+            while (end < chunk.size() && chunk[end] != '\a' &&
+                   chunk[end] != Escape)
+            {
+                ++end;
+            }
+            if (end == chunk.size()) {
+                pos = end;
+                break;
+            }
+            pos = end + 1;
+            if (chunk[end] == '\a') {
+                auto const kind = introducer == ']' ? AnsiEventKind::OSC :
+                                                      AnsiEventKind::DCS;
+                return finishSequence(kind, introducer, end);
+            }
+            state = State::StringEscape;
+            break;
+        }
+        case State::StringEscape:
+            if (c == '\\') {
+                auto const kind = introducer == ']' ? AnsiEventKind::OSC :
+                                                      AnsiEventKind::DCS;
+                return finishSequence(kind, introducer, pos - 1);
+            }
+            // Any other escape sequence cancels the string
+            --pos;
+            restart();
+            break;
+        }
+    }
+    // Keep the part of the sequence in this chunk for the next one
+    auto const rest = chunk.substr(buffered ? 0 : sequenceBegin);
+    std::size_t const count =
+        std::min(rest.size(), buffer.size() - bufferSize);
+    std::memcpy(buffer.data() + bufferSize, rest.data(), count);
+    bufferSize += count;
+    buffered = true;
+    return std::nullopt;
+}
+
+AnsiEvent AnsiParser::finishSequence(AnsiEventKind kind,
+                                     char final,
+                                     std::size_t end) {
+    std::string_view body;
+    if (buffered) {
+        std::size_t const count =
+            std::min(end, buffer.size() - bufferSize);
+        std::memcpy(buffer.data() + bufferSize, chunk.data(), count);
+        bufferSize += count;
+        body = std::string_view(buffer.data(), bufferSize);
+    }
+    else {
+        body = chunk.substr(sequenceBegin, end - sequenceBegin);
+    }
+    state = State::Ground;
+    buffered = false;
+    bufferSize = 0;
+    // String sequences terminated by ST end with the escape character
+    if ((kind == AnsiEventKind::OSC || kind == AnsiEventKind::DCS) &&
+        !body.empty() && body.back() == Escape)
+    {
+        body.remove_suffix(1);
+    }
+    if (kind == AnsiEventKind::CSI) {
+        return makeCSIEvent(body, final);
+    }
+    return AnsiEvent{ .kind = kind, .text = body, .final = final };
+}
+
+AnsiEvent AnsiParser::makeCSIEvent(std::string_view body, char final) {
+    AnsiEvent event{ .kind = AnsiEventKind::CSI, .text = body, .final = final };
+    if (final != 'm') {
+        return event;
+    }
+    // SGR parameters are decimal numbers separated by `;` or `:`. Sequences
+    // with private or intermediate bytes are reported as plain CSI.
+    std::size_t count = 0;
+    unsigned value = 0;
+    std::uint32_t subparams = 0;
+    for (char const c: body) {
+        if (c >= '0' && c <= '9') {
+            value = value * 10 + static_cast<unsigned>(c - '0');
+        }
+        else if ((c == ';' || c == ':') && count + 1 < params.size()) {
+            params[count++] = value;
+            value = 0;
+            if (c == ':') {
+                subparams |= std::uint32_t(1) << count;
+            }
+        }
+        else {
+            return event;
+        }
+    }
+    if (!body.empty()) {
+        params[count++] = value;
+    }
+    event.kind = AnsiEventKind::Style;
+    event.params = std::span(params.data(), count);
+    event.subparams = subparams;
+    return event;
+}
@@ -0,0 +1,232 @@
+#include "termfmt/backtrace.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "platform.h"
+#include "termfmt/termfmt.h"
+
+#if TFMT_UNIX && __has_include(<execinfo.h>)
+#define TFMT_HAS_EXECINFO 1
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#endif
+
+using namespace tfmt;
+
+namespace {
+
+/// Process wide cache of symbolized frames
+/// \details Entries are never evicted. `std::unordered_map` and
+/// `std::unordered_set` never relocate their elements, so the string views
+/// handed out in `StackFrame` objects stay valid.
+class SymbolCache {
+public:
+    static SymbolCache& get() {
+        // Intentionally leaked so backtraces can still be symbolized during
+        // static destruction
+        static SymbolCache* const instance = ::new SymbolCache();
+        return *instance;
+    }
+
+    StackFrame lookup(void const* address) {
+        std::lock_guard lock(mutex);
+        auto itr = frames.find(address);
+        if (itr != frames.end()) {
+            return itr->second;
+        }
+        return frames.insert({ address, resolve(address) }).first->second;
+    }
+
+private:
+    StackFrame resolve(void const* address);
+
+    std::string_view internModule(char const* path) {
+        return *modules.insert(path).first;
+    }
+
+    std::string_view demangle(void const* symbolAddress, char const* name);
+
+    std::mutex mutex;
+    std::unordered_map<void const*, StackFrame> frames;
+    std::unordered_map<void const*, std::string> functions;
+    std::unordered_set<std::string> modules;
+};
+
+} // namespace
+
+#if TFMT_HAS_EXECINFO
+
+StackFrame SymbolCache::resolve(void const* address) {
+    StackFrame frame;
+    frame.address = address;
+    // Return addresses point past the call instruction. We look up the
+    // preceding byte so calls at the very end of a function resolve to the
+    // caller and not to whatever follows it.
+    auto const* lookupAddress = static_cast<char const*>(address) - 1;
+    Dl_info info{};
+    if (!dladdr(lookupAddress, &info)) {
+        return frame;
+    }
+    if (info.dli_fname && info.dli_fbase) {
+        frame.module = internModule(info.dli_fname);
+        frame.moduleOffset = static_cast<char const*>(address) -
+                             static_cast<char const*>(info.dli_fbase);
+    }
+    if (info.dli_sname && info.dli_saddr) {
+        frame.function = demangle(info.dli_saddr, info.dli_sname);
+        frame.offset = static_cast<char const*>(address) -
+                       static_cast<char const*>(info.dli_saddr);
+    }
+    return frame;
+}
+
+std::string_view SymbolCache::demangle(void const* symbolAddress,
+                                       char const* name) {
+    auto itr = functions.find(symbolAddress);
+    if (itr != functions.end()) {
+        return itr->second;
+    }
+    int status = 0;
+    char* demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+    std::string result = status == 0 ? demangled : name;
+    std::free(demangled);
+    return functions.insert({ symbolAddress, std::move(result) })
+        .first->second;
+}
+
+#else
+
+StackFrame SymbolCache::resolve(void const* address) {
+    StackFrame frame;
+    frame.address = address;
+    return frame;
+}
+
+std::string_view SymbolCache::demangle(void const*, char const* name) {
+    return name;
+}
+
+#endif
+
+Backtrace Backtrace::capture(std::size_t skip, std::size_t maxFrames) {
+    Backtrace result;
+    // Also skip the frame of this function
+    ++skip;
+    result.addrs.resize(skip + maxFrames);
+#if TFMT_HAS_EXECINFO
+    int const count =
+        ::backtrace(result.addrs.data(), static_cast<int>(result.addrs.size()));
+    result.addrs.resize(static_cast<std::size_t>(std::max(count, 0)));
+#elif TFMT_WINDOWS
+    USHORT const count =
+        CaptureStackBackTrace(0,
+                              static_cast<DWORD>(result.addrs.size()),
+                              result.addrs.data(),
+                              nullptr);
+    result.addrs.resize(count);
+#else
+    result.addrs.clear();
+#endif
+    skip = std::min(skip, result.addrs.size());
+    result.addrs.erase(result.addrs.begin(), result.addrs.begin() + skip);
+    return result;
+}
+
+StackFrame Backtrace::frame(std::size_t index) const {
+    return SymbolCache::get().lookup(addrs[index]);
+}
+
+static std::string_view basename(std::string_view path) {
+    auto const pos = path.find_last_of("/\\");
+    return pos == std::string_view::npos ? path : path.substr(pos + 1);
+}
+
+static void putPadding(std::ostream& ostream, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+        ostream.put(' ');
+    }
+}
+
+static std::size_t numDigits(std::size_t value) {
+    std::size_t digits = 1;
+    while (value >= 10) {
+        value /= 10;
+        ++digits;
+    }
+    return digits;
+}
+
+void tfmt::printBacktrace(std::ostream& ostream, Backtrace const& backtrace) {
+    static constexpr std::string_view Unknown = "??";
+    std::vector<StackFrame> frames;
+    frames.reserve(backtrace.size());
+    std::size_t functionWidth = Unknown.size();
+    for (std::size_t i = 0; i < backtrace.size(); ++i) {
+        frames.push_back(backtrace.frame(i));
+        functionWidth =
+            std::max(functionWidth, displayWidth(frames.back().function));
+    }
+    std::size_t const indexWidth = numDigits(frames.size()) + 1;
+    // Leave at least this many columns for the module column
+    std::size_t const minModuleWidth = 24;
+    if (auto const width = getWidth(ostream)) {
+        std::size_t const fixed = 2 + indexWidth + 2 + 2 + minModuleWidth;
+        std::size_t const available =
+            *width > fixed + Unknown.size() ? *width - fixed : Unknown.size();
+        functionWidth = std::min(functionWidth, available);
+    }
+    for (std::size_t i = 0; i < frames.size(); ++i) {
+        auto const& frame = frames[i];
+        ostream << "  ";
+        putPadding(ostream, indexWidth - numDigits(i) - 1);
+        ostream << format(BrightGrey, "#", i) << "  ";
+        std::string_view function =
+            frame.function.empty() ? Unknown : frame.function;
+        std::size_t width = displayWidth(function);
+        if (width > functionWidth) {
+            // `functionWidth` is at least two, and the ellipsis occupies one
+            // column
+            function = truncateToWidth(function, functionWidth - 1);
+            width = displayWidth(function) + 1;
+            ostream << format(Bold, function, internal::Ellipsis);
+        }
+        else {
+            ostream << format(Bold, function);
+        }
+        putPadding(ostream, functionWidth - std::min(functionWidth, width));
+        ostream << "  ";
+        char hex[2 * sizeof(void*) + 1];
+        char const* end = std::to_chars(std::begin(hex),
+                                        std::end(hex),
+                                        frame.moduleOffset,
+                                        16)
+                              .ptr;
+        std::string_view const offset(hex, end);
+        if (frame.module.empty()) {
+            ostream << format(BrightGrey, "[", frame.address, "]");
+        }
+        else {
+            ostream << format(Cyan, basename(frame.module))
+                    << format(BrightGrey, "+0x", offset);
+        }
+        ostream << "\n";
+    }
+}
+
+void tfmt::printBacktrace(Backtrace const& backtrace) {
+    printBacktrace(std::cout, backtrace);
+}
+
+std::ostream& tfmt::operator<<(std::ostream& ostream,
+                               Backtrace const& backtrace) {
+    printBacktrace(ostream, backtrace);
+    return ostream;
+}
@@ -0,0 +1,106 @@
+#include "termfmt/builder.h"
+
+#include <cstring>
+
+using namespace tfmt;
+using internal::Attributes;
+
+/// \Returns the size of the longest prefix of \p text with at most \p size
+/// bytes that does not end within a UTF-8 encoded code point
+static std::size_t codePointPrefix(std::string_view text, std::size_t size) {
+    if (size >= text.size()) {
+        return text.size();
+    }
+    // Back off over continuation bytes to the lead byte of the split code
+    // point
+    while (size > 0 && (static_cast<unsigned char>(text[size]) & 0xC0) == 0x80)
+    {
+        --size;
+    }
+    return size;
+}
+
+StyledBuilder::~StyledBuilder() {
+    while (depth > 0) {
+        pop();
+    }
+}
+
+void StyledBuilder::push(Modifier const& mod) {
+    assert(depth < MaxDepth && "Too many modifiers pushed");
+    Attributes const previous = depth > 0 ? states[depth - 1] : Attributes{};
+    Attributes state = internal::combine(previous, mod.attributes());
+    std::string& out = string ? *string : codes;
+    if (!string) {
+        codes.clear();
+    }
+    std::size_t const begin = out.size();
+    if (depth == 0) {
+        // Nothing is applied yet, so the pre-rendered codes of the modifier
+        // are the transition
+        out += mod.ansiBuffer();
+    }
+    else {
+        internal::appendTransition(previous, state, out);
+    }
+    if (string) {
+        states[depth++] = state;
+        return;
+    }
+    // Keep room for the codes that undo the modifier
+    std::size_t const onSize = out.size() - begin;
+    internal::appendTransition(state, previous, codes);
+    std::size_t const offSize = codes.size() - onSize;
+    codes.resize(onSize);
+    if (onSize + offSize > capacity - size - reserved) {
+        // Not applied, so there is nothing to undo either
+        isTruncated = true;
+        state = previous;
+        offSizes[depth] = 0;
+    }
+    else {
+        writeCodes(codes);
+        offSizes[depth] = offSize;
+        reserved += offSize;
+    }
+    states[depth++] = state;
+}
+
+void StyledBuilder::pop() {
+    assert(depth > 0 && "No modifier to pop");
+    --depth;
+    Attributes const previous = depth > 0 ? states[depth - 1] : Attributes{};
+    if (string) {
+        internal::appendTransition(states[depth], previous, *string);
+        return;
+    }
+    // The room for these codes has been reserved by `push()`
+    reserved -= offSizes[depth];
+    codes.clear();
+    internal::appendTransition(states[depth], previous, codes);
+    writeCodes(codes);
+}
+
+void StyledBuilder::write(std::string_view text) {
+    if (string) {
+        *string += text;
+        return;
+    }
+    if (isTruncated) {
+        // Text after a gap would be misleading
+        return;
+    }
+    std::size_t const count =
+        codePointPrefix(text, capacity - size - reserved);
+    if (count < text.size()) {
+        isTruncated = true;
+    }
+    std::memcpy(data + size, text.data(), count);
+    size += count;
+}
+
+void StyledBuilder::writeCodes(std::string_view text) {
+    assert(text.size() <= capacity - size);
+    std::memcpy(data + size, text.data(), text.size());
+    size += text.size();
+}
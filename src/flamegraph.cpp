@@ -0,0 +1,415 @@
+#include "termfmt/flamegraph.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+#include "termfmt/termfmt.h"
+
+using namespace tfmt;
+
+namespace {
+
+/// Bump allocator for objects that are trivially destructible
+class Arena {
+public:
+    Arena() = default;
+    Arena(Arena&&) noexcept = default;
+    Arena& operator=(Arena&&) noexcept = default;
+
+    void* allocate(size_t size, size_t align) {
+        size_t const padding = (align - offset % align) % align;
+        if (blocks.empty() || offset + padding + size > blockSize()) {
+            newBlock(size + align);
+            return allocate(size, align);
+        }
+        void* result = blocks.back().data.get() + offset + padding;
+        offset += padding + size;
+        return result;
+    }
+
+    template <typename T, typename... Args>
+    T* create(Args&&... args) {
+        static_assert(std::is_trivially_destructible_v<T>);
+        return new (allocate(sizeof(T), alignof(T)))
+            T{ std::forward<Args>(args)... };
+    }
+
+    std::string_view copy(std::string_view text) {
+        auto* data = static_cast<char*>(allocate(text.size(), 1));
+        std::memcpy(data, text.data(), text.size());
+        return { data, text.size() };
+    }
+
+private:
+    static constexpr size_t DefaultBlockSize = size_t(64) << 10;
+
+    struct Block {
+        std::unique_ptr<std::byte[]> data;
+        size_t size;
+    };
+
+    size_t blockSize() const { return blocks.back().size; }
+
+    void newBlock(size_t minSize) {
+        size_t const size = std::max(DefaultBlockSize, minSize);
+        blocks.push_back({ std::make_unique<std::byte[]>(size), size });
+        offset = 0;
+    }
+
+    std::vector<Block> blocks;
+    size_t offset = 0;
+};
+
+struct Node {
+    std::string_view name;
+    std::uint64_t hash;
+    std::uint32_t nameID;
+    Node* firstChild;
+    Node* nextSibling;
+    std::uint64_t total;
+};
+
+std::uint64_t hashName(std::string_view name) {
+    // FNV-1a
+    std::uint64_t hash = 0xcbf29ce484222325;
+    for (char const c: name) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001b3;
+    }
+    return hash;
+}
+
+} // namespace
+
+/// Prefix tree of stack frames
+/// \details Nodes and names live in an arena. Frame names are interned, and
+/// children are found through an open addressing hash table keyed by parent
+/// and name ID. The keys are stored in the table, so a lookup touches no node
+/// until it hits.
+class tfmt::internal::FlameGraphTree {
+public:
+    FlameGraphTree() {
+        nameSlots.resize(256, { 0, NoName });
+        childSlots.resize(1024);
+    }
+
+    Node* root() { return &rootNode; }
+
+    Node const* root() const { return &rootNode; }
+
+    /// Start a new stack of \p count samples
+    void beginStack(std::uint64_t count) { rootNode.total += count; }
+
+    /// Add \p count samples to the child \p name of the frame at \p depth
+    /// of the current stack
+    /// \details Consecutive stacks usually share a prefix, e.g. folded
+    /// files are sorted, so we remember the path of the last stack and only
+    /// look up frames after the first difference.
+    void descend(size_t depth, std::string_view name, std::uint64_t count) {
+        Node* node = nullptr;
+        if (depth < path.size() && path[depth]->name == name) {
+            node = path[depth];
+        }
+        else {
+            path.resize(depth);
+            node = child(depth == 0 ? &rootNode : path.back(), name);
+            path.push_back(node);
+        }
+        node->total += count;
+    }
+
+private:
+    struct NameSlot {
+        std::uint64_t hash;
+        std::uint32_t id;
+    };
+
+    struct ChildSlot {
+        Node const* parent;
+        std::uint32_t nameID;
+        Node* node;
+    };
+
+    /// Interned frame name
+    struct Name {
+        std::string_view text;
+        std::uint64_t hash;
+    };
+
+    static constexpr std::uint32_t NoName = ~std::uint32_t(0);
+
+    static std::uint64_t mix(std::uint64_t key) {
+        // Finalizer of MurmurHash3
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccd;
+        key ^= key >> 33;
+        key *= 0xc4ceb9fe1a85ec53;
+        key ^= key >> 33;
+        return key;
+    }
+
+    static std::uint64_t childKey(Node const* parent, std::uint32_t nameID) {
+        return mix(reinterpret_cast<std::uintptr_t>(parent) ^
+                   (std::uint64_t(nameID) << 32 | nameID));
+    }
+
+    /// \Returns the ID of \p text and interns it if it's new
+    std::uint32_t intern(std::string_view text) {
+        std::uint64_t const hash = hashName(text);
+        size_t const mask = nameSlots.size() - 1;
+        for (size_t i = mix(hash) & mask;; i = (i + 1) & mask) {
+            NameSlot& slot = nameSlots[i];
+            if (slot.id == NoName) {
+                slot = { hash, static_cast<std::uint32_t>(names.size()) };
+                names.push_back({ arena.copy(text), hash });
+                if (names.size() * 2 > nameSlots.size()) {
+                    growNames();
+                }
+                return static_cast<std::uint32_t>(names.size() - 1);
+            }
+            if (slot.hash == hash && names[slot.id].text == text) {
+                return slot.id;
+            }
+        }
+    }
+
+    /// \Returns the child \p name of \p parent and creates it if it does
+    /// not exist
+    Node* child(Node* parent, std::string_view name) {
+        std::uint32_t const nameID = intern(name);
+        size_t const mask = childSlots.size() - 1;
+        for (size_t i = childKey(parent, nameID) & mask;; i = (i + 1) & mask) {
+            ChildSlot const& slot = childSlots[i];
+            if (!slot.node) {
+                return insertChild(parent, nameID, i);
+            }
+            if (slot.parent == parent && slot.nameID == nameID) {
+                return slot.node;
+            }
+        }
+    }
+
+    Node* insertChild(Node* parent, std::uint32_t nameID, size_t slot) {
+        Name const& name = names[nameID];
+        Node* node = arena.create<Node>(name.text,
+                                        name.hash,
+                                        nameID,
+                                        nullptr,
+                                        parent->firstChild,
+                                        std::uint64_t(0));
+        parent->firstChild = node;
+        childSlots[slot] = { parent, nameID, node };
+        if (++numNodes * 2 > childSlots.size()) {
+            growChildren();
+        }
+        return node;
+    }
+
+    void growNames() {
+        std::vector<NameSlot> old(nameSlots.size() * 2, { 0, NoName });
+        std::swap(old, nameSlots);
+        size_t const mask = nameSlots.size() - 1;
+        for (NameSlot const& slot: old) {
+            if (slot.id == NoName) {
+                continue;
+            }
+            size_t i = mix(slot.hash) & mask;
+            while (nameSlots[i].id != NoName) {
+                i = (i + 1) & mask;
+            }
+            nameSlots[i] = slot;
+        }
+    }
+
+    void growChildren() {
+        std::vector<ChildSlot> old(childSlots.size() * 2);
+        std::swap(old, childSlots);
+        size_t const mask = childSlots.size() - 1;
+        for (ChildSlot const& slot: old) {
+            if (!slot.node) {
+                continue;
+            }
+            size_t i = childKey(slot.parent, slot.nameID) & mask;
+            while (childSlots[i].node) {
+                i = (i + 1) & mask;
+            }
+            childSlots[i] = slot;
+        }
+    }
+
+    Arena arena;
+    Node rootNode{};
+    std::vector<Node*> path;
+    std::vector<Name> names;
+    std::vector<NameSlot> nameSlots;
+    std::vector<ChildSlot> childSlots;
+    size_t numNodes = 0;
+};
+
+FlameGraph::FlameGraph(): tree(std::make_unique<internal::FlameGraphTree>()) {}
+
+FlameGraph::FlameGraph(FlameGraph&&) noexcept = default;
+
+FlameGraph& FlameGraph::operator=(FlameGraph&&) noexcept = default;
+
+FlameGraph::~FlameGraph() = default;
+
+bool FlameGraph::addFolded(std::string_view line) {
+    while (!line.empty() && (line.back() == '\r' || line.back() == ' ')) {
+        line.remove_suffix(1);
+    }
+    size_t const space = line.rfind(' ');
+    if (space == std::string_view::npos || space == 0) {
+        return false;
+    }
+    std::uint64_t count = 0;
+    auto const* countEnd = line.data() + line.size();
+    auto const res = std::from_chars(line.data() + space + 1, countEnd, count);
+    if (res.ec != std::errc{} || res.ptr != countEnd) {
+        return false;
+    }
+    tree->beginStack(count);
+    std::string_view stack = line.substr(0, space);
+    for (size_t depth = 0; !stack.empty(); ++depth) {
+        size_t const end = std::min(stack.find(';'), stack.size());
+        tree->descend(depth, stack.substr(0, end), count);
+        stack.remove_prefix(std::min(end + 1, stack.size()));
+    }
+    return true;
+}
+
+size_t FlameGraph::parseFolded(std::string_view text) {
+    size_t malformed = 0;
+    while (!text.empty()) {
+        size_t const end = std::min(text.find('\n'), text.size());
+        std::string_view const line = text.substr(0, end);
+        if (!line.empty() && line != "\r" && !addFolded(line)) {
+            ++malformed;
+        }
+        text.remove_prefix(std::min(end + 1, text.size()));
+    }
+    return malformed;
+}
+
+void FlameGraph::addStack(std::span<std::string_view const> frames,
+                          std::uint64_t count) {
+    tree->beginStack(count);
+    for (size_t depth = 0; depth < frames.size(); ++depth) {
+        tree->descend(depth, frames[depth], count);
+    }
+}
+
+std::uint64_t FlameGraph::totalSamples() const { return tree->root()->total; }
+
+static Modifier const& frameModifier(std::uint64_t hash) {
+    static Modifier const palette[] = {
+        BGRed | Grey,          BGYellow | Grey,     BGBrightRed | Grey,
+        BGBrightYellow | Grey, BGMagenta | Grey,    BGBrightMagenta | Grey,
+    };
+    return palette[(hash >> 32) % std::size(palette)];
+}
+
+namespace {
+
+/// A frame in a row of the graph
+struct Cell {
+    Node const* node;
+
+    /// Number of samples left of the frame
+    std::uint64_t offset;
+};
+
+} // namespace
+
+static void putSpaces(std::ostream& ostream, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        ostream.put(' ');
+    }
+}
+
+/// Print \p name into a block of \p width columns
+static void putFrame(std::ostream& ostream,
+                     std::string_view name,
+                     size_t width) {
+    size_t const nameWidth = displayWidth(name);
+    if (nameWidth <= width) {
+        ostream << name;
+        putSpaces(ostream, width - nameWidth);
+    }
+    else if (width >= 2) {
+        ostream << truncateToWidth(name, width - 1) << internal::Ellipsis;
+    }
+    else {
+        putSpaces(ostream, width);
+    }
+}
+
+void FlameGraph::render(std::ostream& ostream,
+                        FlameGraphOptions options) const {
+    Node const* root = tree->root();
+    if (root->total == 0) {
+        return;
+    }
+    size_t const width = options.width.value_or(getWidth(ostream).value_or(80));
+    double const scale = static_cast<double>(width) /
+                         static_cast<double>(root->total);
+    auto column = [&](std::uint64_t offset) {
+        // Positions are computed from global sample offsets, so rounding
+        // errors don't accumulate along a row
+        return std::min(width,
+                        static_cast<size_t>(static_cast<double>(offset) *
+                                            scale));
+    };
+    std::vector<Cell> row = { { root, 0 } };
+    std::vector<Cell> next;
+    std::vector<Node const*> children;
+    for (size_t depth = 0; options.maxDepth == 0 || depth < options.maxDepth;
+         ++depth)
+    {
+        // Lay out the children of the frames of the previous row, sorted
+        // by name like in the usual flame graph tools
+        next.clear();
+        for (auto const& cell: row) {
+            children.clear();
+            for (Node const* child = cell.node->firstChild; child;
+                 child = child->nextSibling)
+            {
+                children.push_back(child);
+            }
+            std::sort(children.begin(),
+                      children.end(),
+                      [](Node const* a, Node const* b) {
+                return a->name < b->name;
+            });
+            std::uint64_t offset = cell.offset;
+            for (Node const* child: children) {
+                if (column(offset + child->total) > column(offset)) {
+                    next.push_back({ child, offset });
+                }
+                offset += child->total;
+            }
+        }
+        if (next.empty()) {
+            break;
+        }
+        std::swap(row, next);
+        size_t position = 0;
+        for (auto const& cell: row) {
+            size_t const begin = column(cell.offset);
+            size_t const end = column(cell.offset + cell.node->total);
+            putSpaces(ostream, begin - position);
+            internal::ModifierRefGuard guard(frameModifier(cell.node->hash),
+                                             ostream);
+            putFrame(ostream, cell.node->name, end - begin);
+            position = end;
+        }
+        ostream.put('\n');
+    }
+}
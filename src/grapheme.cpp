@@ -0,0 +1,184 @@
+#include "termfmt/grapheme.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "unicode_tables.h"
+
+using namespace tfmt;
+
+namespace {
+
+/// Grapheme cluster break property. Must match `BREAK_PROPERTIES` in
+/// scripts/generate_unicode_tables.py
+enum class GraphemeBreak : std::uint8_t {
+    Other,
+    CR,
+    LF,
+    Control,
+    Extend,
+    ZWJ,
+    RegionalIndicator,
+    Prepend,
+    SpacingMark,
+    L,
+    V,
+    T,
+    LV,
+    LVT,
+    ExtendedPictographic,
+};
+
+struct CodePoint {
+    std::uint32_t value;
+    std::size_t size;
+};
+
+} // namespace
+
+static constexpr std::uint32_t ReplacementCharacter = 0xFFFD;
+static constexpr std::uint32_t EmojiPresentationSelector = 0xFE0F;
+
+/// Decode the first code point of the non-empty \p text
+static CodePoint decode(std::string_view text) {
+    auto const byte = [&](std::size_t i) {
+        return static_cast<std::uint8_t>(text[i]);
+    };
+    std::uint8_t const lead = byte(0);
+    if (lead < 0x80) {
+        return { lead, 1 };
+    }
+    std::size_t size = 0;
+    std::uint32_t value = 0;
+    std::uint32_t min = 0;
+    if ((lead & 0xE0) == 0xC0) {
+        size = 2, value = lead & 0x1F, min = 0x80;
+    }
+    else if ((lead & 0xF0) == 0xE0) {
+        size = 3, value = lead & 0x0F, min = 0x800;
+    }
+    else if ((lead & 0xF8) == 0xF0) {
+        size = 4, value = lead & 0x07, min = 0x10000;
+    }
+    else {
+        return { ReplacementCharacter, 1 };
+    }
+    if (text.size() < size) {
+        return { ReplacementCharacter, 1 };
+    }
+    for (std::size_t i = 1; i < size; ++i) {
+        if ((byte(i) & 0xC0) != 0x80) {
+            return { ReplacementCharacter, 1 };
+        }
+        value = value << 6 | (byte(i) & 0x3F);
+    }
+    // Reject overlong encodings, surrogates and values beyond U+10FFFF
+    if (value < min || value > 0x10FFFF || (value >= 0xD800 && value < 0xE000))
+    {
+        return { ReplacementCharacter, 1 };
+    }
+    return { value, size };
+}
+
+static std::uint8_t properties(std::uint32_t cp) {
+    using namespace internal::unicode;
+    if (cp >= TableEnd) {
+        return DefaultProperties;
+    }
+    std::uint32_t const block = BlockIndex[cp >> BlockShift];
+    return Blocks[block << BlockShift | (cp & ((1u << BlockShift) - 1))];
+}
+
+static GraphemeBreak breakProperty(std::uint8_t props) {
+    return GraphemeBreak(props & 0xF);
+}
+
+static std::size_t widthClass(std::uint8_t props) { return props >> 4; }
+
+static bool isControl(GraphemeBreak gcb) {
+    return gcb == GraphemeBreak::CR || gcb == GraphemeBreak::LF ||
+           gcb == GraphemeBreak::Control;
+}
+
+/// \Returns `true` if there is no cluster boundary between \p prev and
+/// \p next by rules GB6 to GB9b of UAX #29
+static bool joinsWith(GraphemeBreak prev, GraphemeBreak next) {
+    using enum GraphemeBreak;
+    switch (next) {
+    case Extend:
+    case ZWJ:
+    case SpacingMark:
+        return true;
+    default:
+        break;
+    }
+    switch (prev) {
+    case Prepend:
+        return true;
+    case L:
+        return next == L || next == V || next == LV || next == LVT;
+    case LV:
+    case V:
+        return next == V || next == T;
+    case LVT:
+    case T:
+        return next == T;
+    default:
+        return false;
+    }
+}
+
+Grapheme tfmt::nextGrapheme(std::string_view text) {
+    using enum GraphemeBreak;
+    if (text.empty()) {
+        return { 0, 0 };
+    }
+    CodePoint cp = decode(text);
+    std::uint8_t props = properties(cp.value);
+    GraphemeBreak prev = breakProperty(props);
+    // GB3 and GB4: Control characters and line breaks are clusters of their
+    // own, except for CR LF
+    if (isControl(prev)) {
+        if (prev == CR && text.size() > 1 && text[1] == '\n') {
+            return { 2, 0 };
+        }
+        return { cp.size, 0 };
+    }
+    std::size_t size = cp.size;
+    std::size_t width = widthClass(props);
+    // State of GB11: The cluster ends with an extended pictographic
+    // character followed by any number of extenders
+    bool emoji = prev == ExtendedPictographic;
+    // ... and a ZWJ
+    bool emojiZWJ = false;
+    // State of GB12 and GB13: Number of regional indicators so far
+    int regionalIndicators = prev == RegionalIndicator;
+    while (size < text.size()) {
+        cp = decode(text.substr(size));
+        props = properties(cp.value);
+        GraphemeBreak const next = breakProperty(props);
+        bool const joins =
+            !isControl(next) &&
+            (joinsWith(prev, next) ||
+             (emojiZWJ && next == ExtendedPictographic) ||
+             (prev == RegionalIndicator && regionalIndicators == 1 &&
+              next == RegionalIndicator));
+        if (!joins) {
+            break;
+        }
+        emojiZWJ = emoji && next == ZWJ;
+        emoji = next == ExtendedPictographic || (emoji && next == Extend);
+        regionalIndicators += next == RegionalIndicator;
+        width = std::max(width, widthClass(props));
+        if (cp.value == EmojiPresentationSelector) {
+            width = 2;
+        }
+        size += cp.size;
+        prev = next;
+    }
+    // Flags are pairs of regional indicators
+    if (regionalIndicators == 2) {
+        width = 2;
+    }
+    return { size, width };
+}
@@ -0,0 +1,266 @@
+#include "termfmt/histogram.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <string>
+
+#include "termfmt/termfmt.h"
+
+using namespace tfmt;
+
+QuantileSketch::QuantileSketch(double relativeAccuracy,
+                               std::size_t maxBuckets):
+    maxBuckets(std::max<std::size_t>(maxBuckets, 2)) {
+    assert(relativeAccuracy > 0 && relativeAccuracy < 1);
+    gamma = (1 + relativeAccuracy) / (1 - relativeAccuracy);
+    logGamma = std::log(gamma);
+    // Values below this would map to indices that don't fit an int
+    minIndexable = std::max(std::exp((std::numeric_limits<int>::min() + 1) *
+                                     logGamma),
+                            std::numeric_limits<double>::min() * gamma);
+}
+
+int QuantileSketch::bucketIndex(double value) const {
+    return static_cast<int>(std::ceil(std::log(value) / logGamma));
+}
+
+double QuantileSketch::bucketValue(int index) const {
+    // The value with the same relative distance to both bucket bounds
+    return 2 * std::pow(gamma, index) / (gamma + 1);
+}
+
+void QuantileSketch::add(double value, std::uint64_t count) {
+    if (count == 0 || std::isnan(value)) {
+        return;
+    }
+    value = std::max(value, 0.0);
+    if (total == 0) {
+        minValue = maxValue = value;
+    }
+    else {
+        minValue = std::min(minValue, value);
+        maxValue = std::max(maxValue, value);
+    }
+    total += count;
+    if (value < minIndexable) {
+        zeroCount += count;
+        return;
+    }
+    addToBucket(bucketIndex(value), count);
+}
+
+void QuantileSketch::addToBucket(int index, std::uint64_t count) {
+    if (counts.empty()) {
+        minIndex = index;
+        counts.push_back(count);
+        return;
+    }
+    if (index < minIndex) {
+        // Below the collapsed range, merge into the lowest bucket
+        if (counts.size() >= maxBuckets) {
+            counts.front() += count;
+            return;
+        }
+        auto const grow = static_cast<std::size_t>(minIndex - index);
+        counts.insert(counts.begin(), grow, 0);
+        minIndex = index;
+    }
+    auto const offset = static_cast<std::size_t>(index - minIndex);
+    if (offset >= counts.size()) {
+        counts.resize(offset + 1, 0);
+    }
+    counts[offset] += count;
+    if (counts.size() > maxBuckets) {
+        // Collapse the lowest buckets to keep the high quantiles accurate
+        std::size_t const excess = counts.size() - maxBuckets;
+        std::uint64_t collapsed = 0;
+        for (std::size_t i = 0; i <= excess; ++i) {
+            collapsed += counts[i];
+        }
+        counts.erase(counts.begin(),
+                     counts.begin() + static_cast<std::ptrdiff_t>(excess));
+        counts.front() = collapsed;
+        minIndex += static_cast<int>(excess);
+    }
+}
+
+void QuantileSketch::merge(QuantileSketch const& other) {
+    assert(gamma == other.gamma && "Sketches must have the same accuracy");
+    if (other.total == 0) {
+        return;
+    }
+    if (total == 0) {
+        minValue = other.minValue;
+        maxValue = other.maxValue;
+    }
+    else {
+        minValue = std::min(minValue, other.minValue);
+        maxValue = std::max(maxValue, other.maxValue);
+    }
+    total += other.total;
+    zeroCount += other.zeroCount;
+    for (std::size_t i = 0; i < other.counts.size(); ++i) {
+        if (other.counts[i] > 0) {
+            addToBucket(other.minIndex + static_cast<int>(i), other.counts[i]);
+        }
+    }
+}
+
+double QuantileSketch::quantile(double q) const {
+    if (total == 0) {
+        return 0;
+    }
+    q = std::clamp(q, 0.0, 1.0);
+    auto const rank =
+        static_cast<std::uint64_t>(q * static_cast<double>(total - 1));
+    std::uint64_t seen = zeroCount;
+    if (rank < seen) {
+        return minValue;
+    }
+    for (std::size_t i = 0; i < counts.size(); ++i) {
+        seen += counts[i];
+        if (rank < seen) {
+            double const value = bucketValue(minIndex + static_cast<int>(i));
+            return std::clamp(value, minValue, maxValue);
+        }
+    }
+    return maxValue;
+}
+
+Histogram::Histogram(double relativeAccuracy): sketch(relativeAccuracy) {}
+
+static Modifier const* selectModifier(std::span<Threshold const> thresholds,
+                                      double value) {
+    Modifier const* mod = nullptr;
+    for (auto& threshold: thresholds) {
+        if (value < threshold.limit) {
+            break;
+        }
+        mod = threshold.modifier;
+    }
+    return mod;
+}
+
+/// Print \p text styled with \p mod if it is not null
+template <typename T>
+static void putStyled(std::ostream& ostream,
+                      Modifier const* mod,
+                      T const& text) {
+    if (!mod) {
+        ostream << text;
+        return;
+    }
+    internal::ModifierRefGuard guard(*mod, ostream);
+    ostream << text;
+}
+
+static void putSpaces(std::ostream& ostream, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+        ostream.put(' ');
+    }
+}
+
+/// Append a bar of \p eighths eighths of a column
+static void appendBar(std::string& bar, std::size_t eighths) {
+    static constexpr std::string_view Partial[] = {
+        "", "▏", "▎", "▍", "▌", "▋", "▊", "▉",
+    };
+    for (std::size_t i = 0; i < eighths / 8; ++i) {
+        bar += "█";
+    }
+    bar += Partial[eighths % 8];
+}
+
+void Histogram::render(std::ostream& ostream,
+                       HistogramOptions const& options) const {
+    if (sketch.count() == 0 || options.bins == 0) {
+        return;
+    }
+    std::size_t const numBins = options.bins;
+    double const low = sketch.min();
+    double const high = sketch.max();
+    // Log scales start at the smallest positive value, zeros go to the
+    // first bin
+    double logLow = low;
+    if (options.logScale && logLow <= 0) {
+        logLow = high;
+        sketch.forEachBucket([&](double value, std::uint64_t) {
+            if (value > 0) {
+                logLow = std::min(logLow, value);
+            }
+        });
+    }
+    bool const logScale = options.logScale && logLow > 0 && high > logLow;
+    auto binStart = [&](std::size_t bin) {
+        double const t = double(bin) / double(numBins);
+        return logScale ? logLow * std::pow(high / logLow, t) :
+                          low + (high - low) * t;
+    };
+    auto binOf = [&](double value) -> std::size_t {
+        double t = 0;
+        if (logScale) {
+            t = value > 0 ? std::log(value / logLow) / std::log(high / logLow) :
+                            0;
+        }
+        else if (high > low) {
+            t = (value - low) / (high - low);
+        }
+        auto const bin = static_cast<std::ptrdiff_t>(t * double(numBins));
+        return static_cast<std::size_t>(
+            std::clamp<std::ptrdiff_t>(bin, 0, std::ptrdiff_t(numBins) - 1));
+    };
+    std::vector<std::uint64_t> binCounts(numBins);
+    sketch.forEachBucket([&](double value, std::uint64_t count) {
+        binCounts[binOf(std::clamp(value, low, high))] += count;
+    });
+    std::vector<FormattedNumber> labels;
+    std::vector<FormattedNumber> counts;
+    std::size_t labelWidth = 0;
+    std::size_t countWidth = 0;
+    for (std::size_t i = 0; i < numBins; ++i) {
+        labels.push_back(formatNumber(binStart(i), options.format));
+        counts.push_back(formatNumber(binCounts[i], { .grouping = true }));
+        labelWidth = std::max(labelWidth, labels.back().width());
+        countWidth = std::max(countWidth, counts.back().width());
+    }
+    std::size_t const width =
+        options.width.value_or(getWidth(ostream).value_or(80));
+    // Layout: "<label> │<bar> <count>"
+    std::size_t const fixed = labelWidth + 2 + 1 + countWidth;
+    std::size_t const barWidth = width > fixed + 1 ? width - fixed - 1 : 1;
+    std::uint64_t const maxCount =
+        *std::max_element(binCounts.begin(), binCounts.end());
+    std::string bar;
+    for (std::size_t i = 0; i < numBins; ++i) {
+        putSpaces(ostream, labelWidth - labels[i].width());
+        ostream << labels[i] << " │";
+        auto const eighths = static_cast<std::size_t>(
+            std::llround(double(binCounts[i]) / double(maxCount) *
+                         double(barWidth * 8)));
+        bar.clear();
+        appendBar(bar, eighths);
+        putStyled(ostream,
+                  selectModifier(options.thresholds, binStart(i)),
+                  bar);
+        putSpaces(ostream, barWidth - (eighths + 7) / 8 + 1);
+        putSpaces(ostream, countWidth - counts[i].width());
+        ostream << counts[i] << '\n';
+    }
+    // Percentile summary
+    bool first = true;
+    for (double const percentile: options.percentiles) {
+        double const value = sketch.quantile(percentile / 100);
+        ostream << (first ? "" : "  ") << 'p'
+                << formatNumber(percentile) << ' ';
+        putStyled(ostream,
+                  selectModifier(options.thresholds, value),
+                  formatNumber(value, options.format));
+        first = false;
+    }
+    if (!first) {
+        ostream << '\n';
+    }
+}
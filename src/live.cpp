@@ -0,0 +1,153 @@
+#include "termfmt/live.h"
+
+#include <algorithm>
+#include <charconv>
+#include <functional>
+#include <ostream>
+
+#include "termfmt/termfmt.h"
+
+using namespace tfmt;
+
+/// Erases a changed line before it is written. Erasing after the text would
+/// erase the last character of a line that fills the width of the terminal,
+/// because the cursor stays on the last column until the next character.
+static constexpr std::string_view LineBegin = "\033[K";
+
+/// Ends a changed line. Styled lines reset the style, so the next line is
+/// erased and begins unstyled.
+static constexpr std::string_view LineEndStyled = "\033[m\n";
+static constexpr std::string_view LineEnd = "\n";
+
+/// Appends the cursor movement `ESC [ count final`
+static void appendMove(std::string& out, std::size_t count, char final) {
+    out += "\033[";
+    if (count > 1) {
+        char buffer[24];
+        out.append(buffer, std::to_chars(buffer, std::end(buffer), count).ptr);
+    }
+    out += final;
+}
+
+/// \Returns the size of the cursor movement appended by `appendMove()`
+static std::size_t moveSize(std::size_t count) {
+    std::size_t size = 3;
+    if (count > 1) {
+        for (; count > 0; count /= 10) {
+            ++size;
+        }
+    }
+    return size;
+}
+
+static std::string_view lineEnd(std::string_view line) {
+    return line.find('\033') == std::string_view::npos ? LineEnd :
+                                                         LineEndStyled;
+}
+
+LiveView::LiveView(std::ostream& ostream): out(ostream) {}
+
+void LiveView::update(std::string_view frame) {
+    ++counters.frames;
+    lines.clear();
+    newHashes.clear();
+    auto const width = getWidth(out);
+    // Every frame but the empty one has at least one, possibly empty, line
+    bool const hasLines = !frame.empty();
+    if (hasLines && frame.back() == '\n') {
+        frame.remove_suffix(1);
+    }
+    while (hasLines) {
+        std::size_t const end = frame.find('\n');
+        std::string_view line = frame.substr(0, end);
+        if (width) {
+            line = truncateToWidth(line, *width);
+        }
+        lines.push_back(line);
+        newHashes.push_back(std::hash<std::string_view>{}(line));
+        if (end == std::string_view::npos) {
+            break;
+        }
+        frame.remove_prefix(end + 1);
+    }
+    buffer.clear();
+    if (!isTermFormattable(out)) {
+        std::size_t size = 0;
+        for (auto line: lines) {
+            size += line.size() + 1;
+        }
+        if (newHashes == hashes) {
+            ++counters.suppressedFrames;
+            counters.bytesSuppressed += size;
+            return;
+        }
+        for (auto line: lines) {
+            buffer += line;
+            buffer += '\n';
+        }
+        hashes.swap(newHashes);
+        write();
+        return;
+    }
+    // Size of a complete redraw
+    std::size_t fullSize = hashes.empty() ? 0 : moveSize(hashes.size());
+    if (!hashes.empty()) {
+        appendMove(buffer, hashes.size(), 'F');
+    }
+    std::size_t skipped = 0;
+    bool changed = false;
+    for (std::size_t i = 0; i < lines.size(); ++i) {
+        std::string_view const end = lineEnd(lines[i]);
+        fullSize += LineBegin.size() + lines[i].size() + end.size();
+        if (i < hashes.size() && hashes[i] == newHashes[i]) {
+            ++skipped;
+            ++counters.suppressedLines;
+            continue;
+        }
+        if (skipped > 0) {
+            appendMove(buffer, skipped, 'E');
+            skipped = 0;
+        }
+        buffer += LineBegin;
+        buffer += lines[i];
+        buffer += end;
+        changed = true;
+    }
+    if (lines.size() < hashes.size()) {
+        if (skipped > 0) {
+            appendMove(buffer, skipped, 'E');
+            skipped = 0;
+        }
+        // Erase the lines of the previous frame below the new one
+        buffer += "\033[J";
+        fullSize += 3;
+        changed = true;
+    }
+    if (skipped > 0) {
+        appendMove(buffer, skipped, 'E');
+    }
+    hashes.swap(newHashes);
+    if (!changed) {
+        ++counters.suppressedFrames;
+        counters.bytesSuppressed += fullSize;
+        return;
+    }
+    counters.bytesSuppressed += fullSize - std::min(fullSize, buffer.size());
+    write();
+}
+
+void LiveView::clear() {
+    if (isTermFormattable(out) && !hashes.empty()) {
+        buffer.clear();
+        appendMove(buffer, hashes.size(), 'F');
+        buffer += "\033[J";
+        write();
+    }
+    hashes.clear();
+}
+
+void LiveView::write() {
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    out.flush();
+    counters.bytesWritten += buffer.size();
+}
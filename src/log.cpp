@@ -0,0 +1,288 @@
+#include "termfmt/log.h"
+
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+
+#include "platform.h"
+#include "termfmt/termfmt.h"
+
+using namespace tfmt;
+
+std::atomic<LogLevel> internal::runtimeLogLevel = LogLevel::Trace;
+
+void tfmt::setLogLevel(LogLevel level) {
+    internal::runtimeLogLevel.store(level, std::memory_order_relaxed);
+}
+
+static std::atomic<LogPrefixFlags> prefixFlags = LogPrefixFlags::None;
+
+void tfmt::setLogPrefixFlags(LogPrefixFlags flags) {
+    prefixFlags.store(flags, std::memory_order_relaxed);
+}
+
+LogPrefixFlags tfmt::getLogPrefixFlags() {
+    return prefixFlags.load(std::memory_order_relaxed);
+}
+
+static constexpr size_t NumLevels = static_cast<size_t>(LogLevel::Off);
+
+static constexpr std::array<std::string_view, NumLevels> LevelNames = {
+    "TRACE", "DEBUG", "INFO", "WARN", "ERROR", "FATAL",
+};
+
+/// Width of the level field, so that messages of all levels line up
+static constexpr size_t LevelWidth = 5;
+
+std::string_view tfmt::logLevelName(LogLevel level) {
+    auto const index = static_cast<size_t>(level);
+    return index < NumLevels ? LevelNames[index] : "";
+}
+
+static Modifier const& levelModifier(LogLevel level) {
+    static Modifier const mods[NumLevels] = {
+        BrightGrey,     Cyan, Green, Yellow | Bold, Red | Bold,
+        BGRed | BrightWhite | Bold,
+    };
+    return mods[static_cast<size_t>(level)];
+}
+
+static Modifier const& timestampModifier() { return BrightGrey; }
+
+static Modifier const& locationModifier() { return BrightBlue; }
+
+namespace {
+
+/// A prefix field rendered with and without ANSI codes
+struct RenderedField {
+    RenderedField() = default;
+
+    RenderedField(Modifier const& mod, std::string_view text):
+        plain(std::string(text) + " "),
+        ansi(std::string(mod.ansiBuffer()) + std::string(text) +
+             std::string(Reset.ansiBuffer()) + " "),
+        ansiOffset(mod.ansiBuffer().size()) {}
+
+    std::string plain;
+    std::string ansi;
+
+    /// Offset of the text in `ansi`
+    size_t ansiOffset = 0;
+};
+
+/// Prefixes of all levels, rendered once
+struct LevelCache {
+    LevelCache() {
+        for (size_t i = 0; i < NumLevels; ++i) {
+            std::string name(LevelNames[i]);
+            name.resize(LevelWidth, ' ');
+            fields[i] = RenderedField(levelModifier(LogLevel(i)), name);
+        }
+    }
+
+    static LevelCache const& get() {
+        static LevelCache const cache;
+        return cache;
+    }
+
+    std::array<RenderedField, NumLevels> fields;
+};
+
+/// Timestamp of the form `HH:MM:SS.mmm`
+/// \details The field is rendered once per second. Within the same second
+/// only the millisecond digits are patched.
+class TimestampCache {
+public:
+    RenderedField const& get(std::chrono::system_clock::time_point now) {
+        using namespace std::chrono;
+        auto const sinceEpoch = now.time_since_epoch();
+        auto const second = duration_cast<seconds>(sinceEpoch).count();
+        if (second != currentSecond) {
+            render(second);
+        }
+        auto const millis = static_cast<unsigned>(
+            duration_cast<milliseconds>(sinceEpoch).count() % 1000);
+        patchMillis(field.plain.data(), millis);
+        patchMillis(field.ansi.data() + field.ansiOffset, millis);
+        return field;
+    }
+
+private:
+    /// Offset of the millisecond digits in `HH:MM:SS.mmm`
+    static constexpr size_t MillisOffset = 9;
+
+    static void patchMillis(char* text, unsigned millis) {
+        text[MillisOffset + 0] = char('0' + millis / 100);
+        text[MillisOffset + 1] = char('0' + millis / 10 % 10);
+        text[MillisOffset + 2] = char('0' + millis % 10);
+    }
+
+    void render(std::int64_t second) {
+        std::time_t const time = static_cast<std::time_t>(second);
+        std::tm local{};
+#if TFMT_UNIX
+        localtime_r(&time, &local);
+#elif TFMT_WINDOWS
+        localtime_s(&local, &time);
+#endif
+        char text[] = "00:00:00.000";
+        auto putTwoDigits = [&](size_t offset, int value) {
+            text[offset] = char('0' + value / 10);
+            text[offset + 1] = char('0' + value % 10);
+        };
+        putTwoDigits(0, local.tm_hour);
+        putTwoDigits(3, local.tm_min);
+        putTwoDigits(6, local.tm_sec);
+        field = RenderedField(timestampModifier(), text);
+        currentSecond = second;
+    }
+
+    std::int64_t currentSecond = -1;
+    RenderedField field;
+};
+
+/// `file:line` fields, rendered once per source location
+class LocationCache {
+public:
+    RenderedField const& get(std::source_location const& location) {
+        Key const key{ location.file_name(), location.line() };
+        auto itr = fields.find(key);
+        if (itr != fields.end()) {
+            return itr->second;
+        }
+        return fields.insert({ key, render(location) }).first->second;
+    }
+
+private:
+    /// File names of source locations are string literals, so we can key by
+    /// address instead of hashing the file name
+    struct Key {
+        char const* file;
+        std::uint_least32_t line;
+
+        bool operator==(Key const&) const = default;
+    };
+
+    struct KeyHash {
+        size_t operator()(Key const& key) const {
+            return std::hash<char const*>{}(key.file) * 31 + key.line;
+        }
+    };
+
+    static RenderedField render(std::source_location const& location) {
+        std::string_view file = location.file_name();
+        auto const pos = file.find_last_of("/\\");
+        if (pos != std::string_view::npos) {
+            file.remove_prefix(pos + 1);
+        }
+        char line[16];
+        char* end =
+            std::to_chars(std::begin(line), std::end(line), location.line())
+                .ptr;
+        std::string text(file);
+        text += ':';
+        text.append(line, end);
+        return RenderedField(locationModifier(), text);
+    }
+
+    std::unordered_map<Key, RenderedField, KeyHash> fields;
+};
+
+} // namespace
+
+static thread_local TimestampCache timestampCache;
+static thread_local LocationCache locationCache;
+
+template <typename CharT, typename Traits>
+static void putBlock(std::basic_ostream<CharT, Traits>& ostream,
+                     std::string_view block) {
+    if constexpr (std::is_same_v<CharT, char>) {
+        ostream.write(block.data(), static_cast<std::streamsize>(block.size()));
+    }
+    else {
+        for (char const c: block) {
+            ostream.put(ostream.widen(c));
+        }
+    }
+}
+
+namespace {
+
+enum class Backend { Plain, ANSI, HTML };
+
+} // namespace
+
+template <typename CharT, typename Traits>
+static void putField(std::basic_ostream<CharT, Traits>& ostream,
+                     Backend backend,
+                     Modifier const& mod,
+                     RenderedField const& field) {
+    switch (backend) {
+    case Backend::Plain:
+        putBlock(ostream, field.plain);
+        break;
+    case Backend::ANSI:
+        putBlock(ostream, field.ansi);
+        break;
+    case Backend::HTML: {
+        std::string_view const text = field.plain;
+        {
+            internal::ModifierRefGuard guard(mod, ostream);
+            putBlock(ostream, text.substr(0, text.size() - 1));
+        }
+        ostream.put(ostream.widen(' '));
+        break;
+    }
+    }
+}
+
+template <typename CharT, typename Traits>
+void tfmt::putLogPrefix(std::basic_ostream<CharT, Traits>& ostream,
+                        LogLevel level,
+                        std::source_location const& location) {
+    auto const index = static_cast<size_t>(level);
+    if (index >= NumLevels) {
+        return;
+    }
+    // SVG streams translate ANSI format codes themselves
+    bool const ansi = isTermFormattable(ostream) || isSVGFormattable(ostream);
+    Backend const backend = isHTMLFormattable(ostream) ? Backend::HTML :
+                            ansi                       ? Backend::ANSI :
+                                                         Backend::Plain;
+    auto const flags = getLogPrefixFlags();
+    if ((flags & LogPrefixFlags::Timestamp) != LogPrefixFlags::None) {
+        auto const& field =
+            timestampCache.get(std::chrono::system_clock::now());
+        putField(ostream, backend, timestampModifier(), field);
+    }
+    putField(ostream,
+             backend,
+             levelModifier(level),
+             LevelCache::get().fields[index]);
+    if ((flags & LogPrefixFlags::Location) != LogPrefixFlags::None &&
+        location.line() != 0)
+    {
+        putField(ostream,
+                 backend,
+                 locationModifier(),
+                 locationCache.get(location));
+    }
+    if (backend == Backend::ANSI) {
+        // The fields end with a reset, so we restore the modifiers that are
+        // active on this stream
+        reapplyModifiers(ostream);
+    }
+}
+
+template void tfmt::putLogPrefix(std::ostream&,
+                                 LogLevel,
+                                 std::source_location const&);
+template void tfmt::putLogPrefix(std::wostream&,
+                                 LogLevel,
+                                 std::source_location const&);
@@ -0,0 +1,261 @@
+#include "termfmt/number.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <type_traits>
+
+#include "termfmt/termfmt.h"
+
+using namespace tfmt;
+
+namespace {
+
+struct UnitScale {
+    double base;
+    std::string_view const* suffixes;
+    size_t count;
+};
+
+constexpr std::string_view SISuffixes[] = { "", "k", "M", "G", "T", "P", "E" };
+
+constexpr std::string_view ByteSuffixes[] = { "B",   "KiB", "MiB", "GiB",
+                                              "TiB", "PiB", "EiB" };
+
+constexpr std::string_view TimeSuffixes[] = { "ns", "µs", "ms", "s" };
+
+UnitScale unitScale(NumberUnit unit) {
+    switch (unit) {
+    case NumberUnit::None:
+        return { 1, nullptr, 0 };
+    case NumberUnit::SI:
+        return { 1000, SISuffixes, std::size(SISuffixes) };
+    case NumberUnit::Bytes:
+        return { 1024, ByteSuffixes, std::size(ByteSuffixes) };
+    case NumberUnit::Nanoseconds:
+        return { 1000, TimeSuffixes, std::size(TimeSuffixes) };
+    }
+    return { 1, nullptr, 0 };
+}
+
+} // namespace
+
+/// Renders numbers into the buffer of a `FormattedNumber`
+class tfmt::internal::NumberFormatter {
+public:
+    explicit NumberFormatter(NumberFormat const& format,
+                             std::span<Threshold const> thresholds,
+                             double value):
+        format(format) {
+        result.alignWidth = format.width;
+        for (auto& threshold: thresholds) {
+            if (value < threshold.limit) {
+                break;
+            }
+            result.mod = threshold.modifier;
+        }
+    }
+
+    template <typename T>
+    FormattedNumber run(T value) {
+        auto const scale = unitScale(format.unit);
+        if (scale.count == 0) {
+            putNumber(value, format.precision);
+            return result;
+        }
+        // Integers that don't need scaling are printed exactly
+        if constexpr (std::is_integral_v<T>) {
+            if (static_cast<double>(value) < scale.base &&
+                static_cast<double>(value) > -scale.base)
+            {
+                putNumber(value, format.precision);
+                putSuffix(scale.suffixes[0]);
+                return result;
+            }
+        }
+        double scaled = static_cast<double>(value);
+        size_t index = 0;
+        while (index + 1 < scale.count && std::abs(scaled) >= scale.base) {
+            scaled /= scale.base;
+            ++index;
+        }
+        auto precisionOf = [&](size_t index) {
+            return format.precision >= 0 ? format.precision :
+                   index > 0             ? 1 :
+                                           -1;
+        };
+        // Values just below the next unit round up to the base, e.g.
+        // 1048575 bytes to 1024.0 KiB, and are printed in the next unit
+        if (int const precision = precisionOf(index);
+            precision >= 0 && index + 1 < scale.count)
+        {
+            double const factor = std::pow(10.0, precision);
+            if (std::abs(std::round(scaled * factor) / factor) >= scale.base) {
+                scaled /= scale.base;
+                ++index;
+            }
+        }
+        putNumber(scaled, precisionOf(index));
+        putSuffix(scale.suffixes[index]);
+        return result;
+    }
+
+private:
+    char* begin() { return result.buffer.data(); }
+
+    char* end() { return result.buffer.data() + FormattedNumber::Capacity; }
+
+    template <typename T>
+    void putNumber(T value, int precision) {
+        char* first = begin();
+        std::to_chars_result res;
+        if constexpr (std::is_integral_v<T>) {
+            res = std::to_chars(first, end(), value);
+            if (res.ec == std::errc{} && precision > 0) {
+                res = appendZeroFraction(res.ptr, precision);
+            }
+        }
+        else {
+            res = precision < 0 ?
+                      std::to_chars(first, end(), value) :
+                      std::to_chars(first,
+                                    end(),
+                                    value,
+                                    std::chars_format::fixed,
+                                    precision);
+            if (res.ec != std::errc{}) {
+                // Fixed notation of huge values does not fit the buffer
+                res = std::to_chars(first,
+                                    end(),
+                                    value,
+                                    std::chars_format::scientific);
+            }
+        }
+        size_t size = static_cast<size_t>(res.ptr - first);
+        if (format.grouping) {
+            size = group(size);
+        }
+        result.size = static_cast<std::uint8_t>(size);
+    }
+
+    std::to_chars_result appendZeroFraction(char* ptr, int precision) {
+        if (end() - ptr < precision + 1) {
+            return { ptr, std::errc::value_too_large };
+        }
+        *ptr++ = '.';
+        std::memset(ptr, '0', static_cast<size_t>(precision));
+        return { ptr + precision, std::errc{} };
+    }
+
+    /// Insert digit separators into the integer part of the first \p size
+    /// characters of the buffer
+    /// \Returns the new size
+    size_t group(size_t size) {
+        char* const first = begin();
+        char* digits = first;
+        if (size > 0 && *digits == '-') {
+            ++digits;
+        }
+        char* intEnd = digits;
+        while (intEnd < first + size && *intEnd >= '0' && *intEnd <= '9') {
+            ++intEnd;
+        }
+        // Exponent notation and non-finite values are not grouped
+        if (std::find_if(intEnd, first + size, [](char c) {
+            return c == 'e' || c == 'n' || c == 'i';
+        }) != first + size || intEnd == digits)
+        {
+            return size;
+        }
+        size_t const numDigits = static_cast<size_t>(intEnd - digits);
+        size_t const numSeparators = (numDigits - 1) / 3;
+        if (size + numSeparators > FormattedNumber::Capacity) {
+            return size;
+        }
+        // Move the fraction and then the digit groups back to front
+        char* src = first + size;
+        char* dest = src + numSeparators;
+        while (src > intEnd) {
+            *--dest = *--src;
+        }
+        for (size_t i = 0; i < numDigits; ++i) {
+            if (i > 0 && i % 3 == 0) {
+                *--dest = format.separator;
+            }
+            *--dest = *--src;
+        }
+        return size + numSeparators;
+    }
+
+    void putSuffix(std::string_view suffix) {
+        if (suffix.empty()) {
+            return;
+        }
+        size_t const size = result.size;
+        if (size + 1 + suffix.size() > FormattedNumber::Capacity) {
+            return;
+        }
+        result.buffer[size] = ' ';
+        std::memcpy(begin() + size + 1, suffix.data(), suffix.size());
+        result.size = static_cast<std::uint8_t>(size + 1 + suffix.size());
+    }
+
+    NumberFormat const& format;
+    FormattedNumber result;
+};
+
+FormattedNumber tfmt::formatNumber(double value,
+                                   NumberFormat const& format,
+                                   std::span<Threshold const> thresholds) {
+    return internal::NumberFormatter(format, thresholds, value).run(value);
+}
+
+FormattedNumber tfmt::formatNumber(std::int64_t value,
+                                   NumberFormat const& format,
+                                   std::span<Threshold const> thresholds) {
+    return internal::NumberFormatter(format,
+                                     thresholds,
+                                     static_cast<double>(value))
+        .run(value);
+}
+
+FormattedNumber tfmt::formatNumber(std::uint64_t value,
+                                   NumberFormat const& format,
+                                   std::span<Threshold const> thresholds) {
+    return internal::NumberFormatter(format,
+                                     thresholds,
+                                     static_cast<double>(value))
+        .run(value);
+}
+
+std::size_t FormattedNumber::width() const {
+    return std::max(alignWidth, displayWidth(text()));
+}
+
+template <typename CharT, typename Traits>
+void FormattedNumber::put(std::basic_ostream<CharT, Traits>& ostream) const {
+    for (size_t i = displayWidth(text()); i < alignWidth; ++i) {
+        ostream.put(ostream.widen(' '));
+    }
+    auto putText = [&] {
+        if constexpr (std::is_same_v<CharT, char>) {
+            ostream.write(buffer.data(), size);
+        }
+        else {
+            for (char const c: text()) {
+                ostream.put(ostream.widen(c));
+            }
+        }
+    };
+    if (!mod) {
+        putText();
+        return;
+    }
+    internal::ModifierRefGuard guard(*mod, ostream);
+    putText();
+}
+
+template void FormattedNumber::put(std::ostream&) const;
+template void FormattedNumber::put(std::wostream&) const;
@@ -0,0 +1,176 @@
+#include "termfmt/optimize.h"
+
+using namespace tfmt;
+using internal::Attributes;
+
+/// Append the shortest SGR sequence that changes the style from \p from to
+/// \p to to \p out
+static void appendShortestTransition(Attributes const& from,
+                                     Attributes const& to,
+                                     std::string& out,
+                                     std::string& scratch) {
+    if (from == to) {
+        return;
+    }
+    if (to == Attributes{}) {
+        out += "\033[m";
+        return;
+    }
+    scratch.clear();
+    internal::appendTransition(from, to, scratch);
+    // A reset followed by the attributes of `to`: "ESC [ 0 ; ... m"
+    std::size_t const targetedSize = scratch.size();
+    std::size_t const resetSize = out.size();
+    internal::appendTransition({}, to, out);
+    std::size_t const fromResetSize = out.size() - resetSize + 2;
+    if (fromResetSize < targetedSize) {
+        out.insert(resetSize + 2, "0;");
+        return;
+    }
+    out.resize(resetSize);
+    out += scratch;
+}
+
+void SGROptimizer::optimize(std::string_view chunk, std::string& out) {
+    numBytesIn += chunk.size();
+    std::size_t const initialSize = out.size();
+    parser.feed(chunk);
+    std::size_t begin = 0;
+    while (auto event = parser.next()) {
+        std::size_t const end = parser.consumed();
+        std::string_view raw = chunk.substr(begin, end - begin);
+        if (!partial.empty()) {
+            partial += raw;
+            raw = partial;
+        }
+        handle(*event, raw, out);
+        partial.clear();
+        begin = end;
+    }
+    // The rest of the chunk belongs to a sequence that continues in the next
+    // chunk
+    partial += chunk.substr(begin);
+    numBytesOut += out.size() - initialSize;
+}
+
+void SGROptimizer::flush(std::string& out) {
+    std::size_t const initialSize = out.size();
+    emitStyle(out);
+    numBytesOut += out.size() - initialSize;
+}
+
+void SGROptimizer::finish(std::string& out) {
+    std::size_t const initialSize = out.size();
+    emitStyle(out);
+    out += partial;
+    partial.clear();
+    parser.reset();
+    numBytesOut += out.size() - initialSize;
+}
+
+void SGROptimizer::handle(AnsiEvent const& event,
+                          std::string_view raw,
+                          std::string& out) {
+    switch (event.kind) {
+    case AnsiEventKind::Text:
+        emitStyle(out);
+        out += raw;
+        return;
+    case AnsiEventKind::Control:
+        out += raw;
+        return;
+    case AnsiEventKind::Style: {
+        Attributes next = target;
+        bool const untracked =
+            internal::applySGR(next, event.params, event.subparams);
+        // Only a reset clears the untracked attributes set before it
+        bool const wasReset = next.reset;
+        next.reset = false;
+        if (!hasUntracked && !untracked) {
+            target = next;
+            return;
+        }
+        // Untracked attributes can only be set by the sequence itself, which
+        // sets the tracked ones as well. While they may be set, the style on
+        // the terminal is not fully known, and a transition computed from
+        // `emitted` could drop a reset that clears them, so all SGR
+        // sequences are copied verbatim until a reset.
+        emitStyle(out);
+        out += raw;
+        hasUntracked = untracked || (hasUntracked && !wasReset);
+        target = next;
+        emitted = target;
+        return;
+    }
+    default:
+        emitStyle(out);
+        out += raw;
+        return;
+    }
+}
+
+void SGROptimizer::emitStyle(std::string& out) {
+    appendShortestTransition(emitted, target, out, transition);
+    emitted = target;
+}
+
+SGROptimizingStreambuf::SGROptimizingStreambuf(std::ostream& dest):
+    dest(dest) {
+    setp(buffer.data(), buffer.data() + buffer.size());
+}
+
+SGROptimizingStreambuf::~SGROptimizingStreambuf() { finish(true); }
+
+SGROptimizingStreambuf::int_type SGROptimizingStreambuf::overflow(
+    int_type ch) {
+    drain();
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+    return traits_type::not_eof(ch);
+}
+
+std::streamsize SGROptimizingStreambuf::xsputn(char const* data,
+                                               std::streamsize count) {
+    drain();
+    write(std::string_view(data, static_cast<std::size_t>(count)));
+    return count;
+}
+
+int SGROptimizingStreambuf::sync() {
+    finish(false);
+    dest.flush();
+    return 0;
+}
+
+void SGROptimizingStreambuf::write(std::string_view text) {
+    optimized.clear();
+    opt.optimize(text, optimized);
+    dest.write(optimized.data(),
+               static_cast<std::streamsize>(optimized.size()));
+}
+
+void SGROptimizingStreambuf::drain() {
+    auto const size = static_cast<std::size_t>(pptr() - pbase());
+    write(std::string_view(pbase(), size));
+    setp(buffer.data(), buffer.data() + buffer.size());
+}
+
+void SGROptimizingStreambuf::finish(bool endOfInput) {
+    drain();
+    optimized.clear();
+    if (endOfInput) {
+        opt.finish(optimized);
+    }
+    else {
+        opt.flush(optimized);
+    }
+    dest.write(optimized.data(),
+               static_cast<std::streamsize>(optimized.size()));
+}
+
+SGROptimizingStream::SGROptimizingStream(std::ostream& dest):
+    std::ostream(&buf), buf(dest) {
+    copyFormatFlags(dest, *this);
+}
@@ -0,0 +1,23 @@
+#ifndef TERMFORMAT_PLATFORM_H_
+#define TERMFORMAT_PLATFORM_H_
+
+#if !defined(_WIN32) && (defined(__unix__) || defined(__unix) ||               \
+                         (defined(__APPLE__) && defined(__MACH__)))
+#define TFMT_UNIX 1
+#elif defined(_WIN32)
+#define TFMT_WINDOWS 1
+#else
+#error Unknown platform
+#endif
+
+#if TFMT_UNIX
+#include <stdio.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#elif TFMT_WINDOWS
+// #   define NOMINMAX
+#include <io.h>
+#include <windows.h>
+#endif
+
+#endif // TERMFORMAT_PLATFORM_H_
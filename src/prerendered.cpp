@@ -0,0 +1,97 @@
+#include "termfmt/prerendered.h"
+
+#include <optional>
+
+#include "termfmt/string_stream.h"
+
+using namespace tfmt;
+using internal::Attributes;
+
+enum : std::uint8_t {
+    TermFlag = 1 << 0,
+    HTMLFlag = 1 << 1,
+    SVGFlag = 1 << 2,
+};
+
+Prerendered::~Prerendered() {
+    for (auto& rendering: renderings) {
+        delete rendering.load(std::memory_order_relaxed);
+    }
+}
+
+void Prerendered::put(std::ostream& ostream) const {
+    Key const key{
+        .flags = static_cast<std::uint8_t>(
+            (isTermFormattable(ostream) ? TermFlag : 0) |
+            (isHTMLFormattable(ostream) ? HTMLFlag : 0) |
+            (isSVGFormattable(ostream) ? SVGFlag : 0)),
+        .base = internal::currentAttributes(ostream),
+        .fmtflags = ostream.flags(),
+        .width = ostream.width(),
+        .precision = ostream.precision(),
+        .fill = ostream.fill(),
+        .locale = ostream.getloc(),
+    };
+    // The width applies to this insertion only, as for formatted output
+    ostream.width(0);
+    if (auto const* rendering = find(key)) {
+        ostream.write(rendering->bytes.data(),
+                      static_cast<std::streamsize>(rendering->bytes.size()));
+        return;
+    }
+    std::string bytes = render(key);
+    ostream.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    std::lock_guard lock(mutex);
+    if (find(key)) {
+        return;
+    }
+    for (auto& rendering: renderings) {
+        if (!rendering.load(std::memory_order_relaxed)) {
+            rendering.store(new Rendering{ key, std::move(bytes) },
+                            std::memory_order_release);
+            return;
+        }
+    }
+    // All slots are taken, so streams with this key are rendered every time
+}
+
+Prerendered::Rendering const* Prerendered::find(Key const& key) const {
+    for (auto& slot: renderings) {
+        auto const* rendering = slot.load(std::memory_order_acquire);
+        if (!rendering) {
+            return nullptr;
+        }
+        if (rendering->key == key) {
+            return rendering;
+        }
+    }
+    return nullptr;
+}
+
+std::string Prerendered::render(Key const& key) const {
+    PooledStringStream stream;
+    setTermFormattable(*stream, key.flags & TermFlag);
+    setHTMLFormattable(*stream, key.flags & HTMLFlag);
+    setSVGFormattable(*stream, key.flags & SVGFlag);
+    stream->flags(key.fmtflags);
+    stream->width(key.width);
+    stream->precision(key.precision);
+    stream->fill(key.fill);
+    stream->imbue(key.locale);
+    // Recreate the attributes in effect on the destination, so the fragment
+    // transitions from and back to them
+    std::optional<Modifier> base;
+    if (key.base != Attributes{}) {
+        std::string codes;
+        internal::appendTransition({}, key.base, codes);
+        base.emplace(codes, std::string{});
+        pushModifierRef(*base, *stream);
+    }
+    std::size_t const begin = stream.view().size();
+    renderFn(*stream);
+    std::string bytes(stream.view().substr(begin));
+    if (base) {
+        popModifier(*stream);
+    }
+    return bytes;
+}
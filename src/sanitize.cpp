@@ -0,0 +1,187 @@
+#include "termfmt/sanitize.h"
+
+#include <ostream>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define TFMT_SANITIZE_SSE2 1
+#else
+#define TFMT_SANITIZE_SSE2 0
+#endif
+
+#include "termfmt/ansi.h"
+#include "termfmt/termfmt.h"
+
+using namespace tfmt;
+
+static constexpr char Escape = '\033';
+
+/// Lead byte of the UTF-8 encoding of U+0080 to U+00BF, which include the C1
+/// control characters
+static constexpr unsigned char C1Lead = 0xC2;
+
+static bool isSuspicious(unsigned char c) {
+    return c < 0x20 || c == 0x7F || c == C1Lead;
+}
+
+/// \Returns the offset of the first byte in \p text at or after \p pos that
+/// may start a control character, or `text.size()`
+static std::size_t findSuspicious(std::string_view text, std::size_t pos) {
+    auto const* const data =
+        reinterpret_cast<unsigned char const*>(text.data());
+    std::size_t const size = text.size();
+#if TFMT_SANITIZE_SSE2
+    __m128i const maxControl = _mm_set1_epi8(0x1F);
+    __m128i const del = _mm_set1_epi8(0x7F);
+    __m128i const c1Lead = _mm_set1_epi8(static_cast<char>(C1Lead));
+    for (; pos + 16 <= size; pos += 16) {
+        __m128i const block =
+            _mm_loadu_si128(reinterpret_cast<__m128i const*>(data + pos));
+        __m128i const matches = _mm_or_si128(
+            _mm_cmpeq_epi8(_mm_min_epu8(block, maxControl), block),
+            _mm_or_si128(_mm_cmpeq_epi8(block, del),
+                         _mm_cmpeq_epi8(block, c1Lead)));
+        if (int const mask = _mm_movemask_epi8(matches)) {
+#if defined(_MSC_VER)
+            unsigned long index;
+            _BitScanForward(&index, static_cast<unsigned long>(mask));
+            return pos + index;
+#else
+            return pos + static_cast<std::size_t>(
+                             __builtin_ctz(static_cast<unsigned>(mask)));
+#endif
+        }
+    }
+#endif
+    for (; pos < size; ++pos) {
+        if (isSuspicious(data[pos])) {
+            return pos;
+        }
+    }
+    return size;
+}
+
+/// \Returns the size of the SGR sequence at the beginning of \p text or zero
+/// if \p text does not start with a complete SGR sequence
+static std::size_t styleSequenceSize(std::string_view text) {
+    if (text.size() < 3 || text[0] != Escape || text[1] != '[') {
+        return 0;
+    }
+    for (std::size_t i = 2; i < text.size(); ++i) {
+        char const c = text[i];
+        if (c == 'm') {
+            return i + 1;
+        }
+        if ((c < '0' || c > '9') && c != ';' && c != ':') {
+            return 0;
+        }
+    }
+    return 0;
+}
+
+/// \Returns the size of the escape sequence at the beginning of \p text .
+/// Incomplete sequences extend to the end of \p text .
+static std::size_t escapeSequenceSize(std::string_view text) {
+    AnsiParser parser;
+    parser.feed(text);
+    parser.next();
+    return parser.consumed();
+}
+
+/// Pass the runs of sanitized \p text to \p sink
+/// \Returns `true` if an SGR sequence has been passed
+template <typename Sink>
+static bool sanitizeImpl(std::string_view text,
+                         SanitizeOptions const& options,
+                         bool allowStyles,
+                         Sink&& sink) {
+    bool const caret = options.mode == SanitizeMode::Caret;
+    bool styled = false;
+    std::size_t begin = 0;
+    std::size_t pos = 0;
+    while (true) {
+        pos = findSuspicious(text, pos);
+        if (pos == text.size()) {
+            break;
+        }
+        auto const c = static_cast<unsigned char>(text[pos]);
+        if (c == C1Lead) {
+            // Other code points with this lead byte are printable
+            if (pos + 1 == text.size() ||
+                static_cast<unsigned char>(text[pos + 1]) > 0x9F)
+            {
+                ++pos;
+                continue;
+            }
+        }
+        else if (c < 0x20 && (options.allowedControls >> c & 1)) {
+            ++pos;
+            continue;
+        }
+        else if (c == Escape && allowStyles) {
+            if (std::size_t const size = styleSequenceSize(text.substr(pos))) {
+                pos += size;
+                styled = true;
+                continue;
+            }
+        }
+        sink(text.substr(begin, pos - begin));
+        if (c == C1Lead) {
+            // Like `cat -v`: U+009B is printed as M-^[
+            if (caret) {
+                auto const code = static_cast<unsigned char>(text[pos + 1]);
+                char const notation[] = { 'M', '-', '^',
+                                          static_cast<char>((code - 0x80) ^
+                                                            0x40) };
+                sink(std::string_view(notation, sizeof notation));
+            }
+            pos += 2;
+        }
+        else if (caret) {
+            char const notation[] = { '^', static_cast<char>(c ^ 0x40) };
+            sink(std::string_view(notation, sizeof notation));
+            pos += 1;
+        }
+        else if (c == Escape) {
+            pos += escapeSequenceSize(text.substr(pos));
+        }
+        else {
+            pos += 1;
+        }
+        begin = pos;
+    }
+    sink(text.substr(begin));
+    return styled;
+}
+
+std::string tfmt::sanitize(std::string_view text,
+                           SanitizeOptions const& options) {
+    std::string out;
+    out.reserve(text.size());
+    bool const styled =
+        sanitizeImpl(text, options, options.allowStyles,
+                     [&](std::string_view run) { out += run; });
+    // The style set by the text ends with it
+    if (styled) {
+        out += "\033[m";
+    }
+    return out;
+}
+
+void tfmt::sanitize(std::ostream& ostream,
+                    std::string_view text,
+                    SanitizeOptions const& options) {
+    bool const allowStyles = options.allowStyles &&
+                             (isTermFormattable(ostream) ||
+                              isSVGFormattable(ostream));
+    bool const styled = sanitizeImpl(text, options, allowStyles,
+                                     [&](std::string_view run) {
+        if (!run.empty()) {
+            ostream.write(run.data(), static_cast<std::streamsize>(run.size()));
+        }
+    });
+    if (styled) {
+        ostream << "\033[m";
+        reapplyModifiers(ostream);
+    }
+}
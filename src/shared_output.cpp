@@ -0,0 +1,505 @@
+#include "termfmt/shared_output.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "platform.h"
+#include "termfmt/termfmt.h"
+
+#if TFMT_UNIX
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#endif
+
+using namespace tfmt;
+
+/// Write all of \p data to \p fd
+static void writeAll(int fd, std::string_view data) {
+    while (!data.empty()) {
+#if TFMT_UNIX
+        auto const written = ::write(fd, data.data(), data.size());
+#elif TFMT_WINDOWS
+        auto const written =
+            _write(fd,
+                   data.data(),
+                   static_cast<unsigned>(std::min<size_t>(data.size(),
+                                                          INT_MAX)));
+#endif
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        data.remove_prefix(static_cast<size_t>(written));
+    }
+}
+
+#if TFMT_UNIX
+
+namespace {
+
+constexpr std::uint64_t Magic = 0x7466'6d74'7368'6f31; // "tfmtsho1"
+
+/// Layout of the beginning of the shared memory object. The ring data
+/// follows the header.
+struct RingHeader {
+    std::atomic<std::uint64_t> magic;
+    std::uint64_t capacity;
+    pthread_mutex_t mutex;
+    pthread_cond_t nonEmpty;
+    pthread_cond_t nonFull;
+    /// Total number of bytes submitted
+    std::uint64_t head;
+    /// Total number of bytes written by the leader
+    std::uint64_t tail;
+};
+
+/// Scoped lock of the robust mutex of the ring
+class RingLock {
+public:
+    explicit RingLock(RingHeader& header): header(header) {
+        recover(pthread_mutex_lock(&header.mutex));
+    }
+
+    RingLock(RingLock const&) = delete;
+    RingLock& operator=(RingLock const&) = delete;
+
+    ~RingLock() { pthread_mutex_unlock(&header.mutex); }
+
+    /// Wait on \p cond for at most \p timeout
+    /// \Returns `false` on timeout
+    bool wait(pthread_cond_t& cond, std::chrono::milliseconds timeout) {
+        timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        auto const nanos = deadline.tv_nsec + timeout.count() * 1'000'000;
+        deadline.tv_sec += static_cast<time_t>(nanos / 1'000'000'000);
+        deadline.tv_nsec = static_cast<long>(nanos % 1'000'000'000);
+        int const result =
+            pthread_cond_timedwait(&cond, &header.mutex, &deadline);
+        recover(result);
+        return result != ETIMEDOUT;
+    }
+
+private:
+    void recover(int result) {
+        // The previous owner died while holding the lock. The head is only
+        // advanced after a line and its line break are copied completely,
+        // so the ring is consistent.
+        if (result == EOWNERDEAD) {
+            pthread_mutex_consistent(&header.mutex);
+        }
+    }
+
+    RingHeader& header;
+};
+
+} // namespace
+
+#endif // TFMT_UNIX
+
+class tfmt::internal::SharedOutputChannel {
+public:
+    SharedOutputChannel(std::string_view name, SharedOutputOptions options):
+        fd(options.fd) {
+#if TFMT_UNIX
+        open(name, options.capacity);
+#else
+        (void)name;
+#endif
+    }
+
+    SharedOutputChannel(SharedOutputChannel const&) = delete;
+    SharedOutputChannel& operator=(SharedOutputChannel const&) = delete;
+
+    ~SharedOutputChannel() {
+#if TFMT_UNIX
+        if (!header) {
+            return;
+        }
+        flush();
+        if (drainer.joinable()) {
+            stopping = true;
+            {
+                RingLock lock(*header);
+                pthread_cond_broadcast(&header->nonEmpty);
+            }
+            drainer.join();
+        }
+        if (lockFD >= 0) {
+            // Closing the file releases the lock, so another process can
+            // take over
+            close(lockFD);
+        }
+        munmap(header, mappingSize);
+#endif
+    }
+
+    void submit(std::string_view line) {
+        bool const addNewline = line.empty() || line.back() != '\n';
+#if TFMT_UNIX
+        if (header) {
+            submitShared(line, addNewline);
+            return;
+        }
+#endif
+        std::lock_guard lock(localMutex);
+        localBuffer.assign(line);
+        if (addNewline) {
+            localBuffer += '\n';
+        }
+        writeAll(fd, localBuffer);
+    }
+
+    void flush() {
+#if TFMT_UNIX
+        if (!header) {
+            return;
+        }
+        RingLock lock(*header);
+        while (header->head != header->tail) {
+            if (!lock.wait(header->nonFull, PollInterval)) {
+                tryLead();
+            }
+        }
+#endif
+    }
+
+    bool isLeader() const { return leader; }
+
+    bool isShared() const {
+#if TFMT_UNIX
+        return header != nullptr;
+#else
+        return false;
+#endif
+    }
+
+    int outputFD() const { return fd; }
+
+    static void remove(std::string_view name) {
+#if TFMT_UNIX
+        shm_unlink(shmName(name).c_str());
+        unlink(lockPath(name).c_str());
+#else
+        (void)name;
+#endif
+    }
+
+private:
+    /// Interval in which producers waiting for space check if the leader is
+    /// still alive
+    static constexpr std::chrono::milliseconds PollInterval{ 100 };
+
+#if TFMT_UNIX
+    static std::string shmName(std::string_view name) {
+        return "/tfmt-" + std::string(name);
+    }
+
+    static std::string lockPath(std::string_view name) {
+        char const* dir = std::getenv("TMPDIR");
+        if (!dir || !*dir) {
+            dir = "/tmp";
+        }
+        return std::string(dir) + "/tfmt-" + std::string(name) + ".lock";
+    }
+
+    void open(std::string_view name, size_t capacity) {
+        auto const path = shmName(name);
+        bool created = true;
+        int shmFD = shm_open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (shmFD < 0 && errno == EEXIST) {
+            created = false;
+            shmFD = shm_open(path.c_str(), O_RDWR, 0600);
+        }
+        if (shmFD < 0) {
+            return;
+        }
+        if (created) {
+            mappingSize = sizeof(RingHeader) + capacity;
+            if (ftruncate(shmFD, static_cast<off_t>(mappingSize)) != 0) {
+                close(shmFD);
+                shm_unlink(path.c_str());
+                return;
+            }
+        }
+        else if (!waitForSize(shmFD)) {
+            close(shmFD);
+            return;
+        }
+        void* addr = mmap(nullptr,
+                          mappingSize,
+                          PROT_READ | PROT_WRITE,
+                          MAP_SHARED,
+                          shmFD,
+                          0);
+        close(shmFD);
+        if (addr == MAP_FAILED) {
+            return;
+        }
+        auto* ring = static_cast<RingHeader*>(addr);
+        if (created) {
+            initialize(*ring, capacity);
+        }
+        else if (!waitForInitialization(*ring)) {
+            munmap(addr, mappingSize);
+            return;
+        }
+        // Without the lock file nobody could become the leader and drain
+        // the ring. The name is predictable, so symbolic links are not
+        // followed.
+        lockFD = ::open(lockPath(name).c_str(),
+                        O_RDWR | O_CREAT | O_NOFOLLOW | O_CLOEXEC,
+                        0600);
+        if (lockFD < 0) {
+            munmap(addr, mappingSize);
+            return;
+        }
+        header = ring;
+        data = reinterpret_cast<char*>(ring + 1);
+        tryLead();
+    }
+
+    /// The creator truncates the object right after creating it, we wait
+    /// until it has done so
+    bool waitForSize(int shmFD) {
+        for (int i = 0; i < 1000; ++i) {
+            struct stat info;
+            if (fstat(shmFD, &info) != 0) {
+                return false;
+            }
+            if (static_cast<size_t>(info.st_size) > sizeof(RingHeader)) {
+                mappingSize = static_cast<size_t>(info.st_size);
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return false;
+    }
+
+    static bool waitForInitialization(RingHeader& ring) {
+        for (int i = 0; i < 1000; ++i) {
+            if (ring.magic.load(std::memory_order_acquire) == Magic) {
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return false;
+    }
+
+    static void initialize(RingHeader& ring, size_t capacity) {
+        ring.capacity = capacity;
+        ring.head = 0;
+        ring.tail = 0;
+        pthread_mutexattr_t mutexAttr;
+        pthread_mutexattr_init(&mutexAttr);
+        pthread_mutexattr_setpshared(&mutexAttr, PTHREAD_PROCESS_SHARED);
+        pthread_mutexattr_setrobust(&mutexAttr, PTHREAD_MUTEX_ROBUST);
+        pthread_mutex_init(&ring.mutex, &mutexAttr);
+        pthread_mutexattr_destroy(&mutexAttr);
+        pthread_condattr_t condAttr;
+        pthread_condattr_init(&condAttr);
+        pthread_condattr_setpshared(&condAttr, PTHREAD_PROCESS_SHARED);
+        pthread_cond_init(&ring.nonEmpty, &condAttr);
+        pthread_cond_init(&ring.nonFull, &condAttr);
+        pthread_condattr_destroy(&condAttr);
+        ring.magic.store(Magic, std::memory_order_release);
+    }
+
+    /// Become the leader if no other process is. Must hold the lock, which
+    /// also serializes the threads of this process.
+    void tryLead() {
+        if (leader || lockFD < 0) {
+            return;
+        }
+        lastLeadAttempt = std::chrono::steady_clock::now();
+        if (flock(lockFD, LOCK_EX | LOCK_NB) != 0) {
+            return;
+        }
+        leader = true;
+        drainer = std::thread([this] { drain(); });
+    }
+
+    void submitShared(std::string_view line, bool addNewline) {
+        size_t const size = line.size() + addNewline;
+        RingLock lock(*header);
+        if (!leader &&
+            std::chrono::steady_clock::now() - lastLeadAttempt > PollInterval)
+        {
+            tryLead();
+        }
+        size_t const capacity = header->capacity;
+        if (size > capacity) {
+            // Too large for the ring. We wait until everything before it is
+            // written and write it ourselves while holding the lock.
+            while (header->head != header->tail) {
+                if (!lock.wait(header->nonFull, PollInterval)) {
+                    tryLead();
+                }
+            }
+            localBuffer.assign(line);
+            if (addNewline) {
+                localBuffer += '\n';
+            }
+            writeAll(fd, localBuffer);
+            return;
+        }
+        while (capacity - (header->head - header->tail) < size) {
+            if (!lock.wait(header->nonFull, PollInterval)) {
+                tryLead();
+            }
+        }
+        size_t const offset = header->head % capacity;
+        copy(offset, line);
+        if (addNewline) {
+            copy((offset + line.size()) % capacity, "\n");
+        }
+        // The line and its line break are published together, so readers
+        // never see one without the other
+        header->head += size;
+        pthread_cond_signal(&header->nonEmpty);
+    }
+
+    /// Copy \p text to \p offset in the ring, wrapping around at its end.
+    /// Must hold the lock.
+    void copy(size_t offset, std::string_view text) {
+        size_t const capacity = header->capacity;
+        size_t const first = std::min(text.size(), capacity - offset);
+        std::memcpy(data + offset, text.data(), first);
+        std::memcpy(data, text.data() + first, text.size() - first);
+    }
+
+    /// Body of the leader thread: Writes everything that is pending in one
+    /// batch. The tail is advanced after the write, so a producer that sees
+    /// an empty ring knows that all lines have reached the terminal.
+    void drain() {
+        std::vector<char> batch;
+        RingLock lock(*header);
+        while (true) {
+            while (header->head == header->tail && !stopping) {
+                lock.wait(header->nonEmpty, PollInterval);
+            }
+            if (header->head == header->tail) {
+                break;
+            }
+            size_t const capacity = header->capacity;
+            size_t const size = header->head - header->tail;
+            size_t const offset = header->tail % capacity;
+            size_t const first = std::min(size, capacity - offset);
+            batch.resize(size);
+            std::memcpy(batch.data(), data + offset, first);
+            std::memcpy(batch.data() + first, data, size - first);
+            pthread_mutex_unlock(&header->mutex);
+            writeAll(fd, { batch.data(), batch.size() });
+            // RingLock's destructor unlocks, so we always re-lock here
+            int const result = pthread_mutex_lock(&header->mutex);
+            if (result == EOWNERDEAD) {
+                pthread_mutex_consistent(&header->mutex);
+            }
+            header->tail += size;
+            pthread_cond_broadcast(&header->nonFull);
+        }
+    }
+
+    RingHeader* header = nullptr;
+    char* data = nullptr;
+    size_t mappingSize = 0;
+    int lockFD = -1;
+    std::thread drainer;
+    std::atomic<bool> stopping = false;
+    std::chrono::steady_clock::time_point lastLeadAttempt;
+#endif // TFMT_UNIX
+
+    int fd;
+    std::atomic<bool> leader = false;
+    std::mutex localMutex;
+    /// Line that is written directly. Guarded by the ring lock if the channel
+    /// is shared, otherwise by `localMutex`.
+    std::string localBuffer;
+};
+
+SharedOutput::SharedOutput(std::string_view name, SharedOutputOptions options):
+    channel(std::make_unique<internal::SharedOutputChannel>(name, options)) {}
+
+SharedOutput::~SharedOutput() = default;
+
+void SharedOutput::submit(std::string_view line) { channel->submit(line); }
+
+void SharedOutput::flush() { channel->flush(); }
+
+bool SharedOutput::isLeader() const { return channel->isLeader(); }
+
+bool SharedOutput::isShared() const { return channel->isShared(); }
+
+int SharedOutput::fd() const { return channel->outputFD(); }
+
+void SharedOutput::remove(std::string_view name) {
+    internal::SharedOutputChannel::remove(name);
+}
+
+SharedOutputStreambuf::~SharedOutputStreambuf() {
+    if (!pending.empty()) {
+        output.submit(pending);
+    }
+}
+
+SharedOutputStreambuf::int_type SharedOutputStreambuf::overflow(int_type ch) {
+    if (traits_type::eq_int_type(ch, traits_type::eof())) {
+        return traits_type::not_eof(ch);
+    }
+    pending += traits_type::to_char_type(ch);
+    if (ch == '\n') {
+        submitLines();
+    }
+    return ch;
+}
+
+std::streamsize SharedOutputStreambuf::xsputn(char const* data,
+                                              std::streamsize count) {
+    std::string_view const text(data, static_cast<size_t>(count));
+    pending += text;
+    if (text.find('\n') != std::string_view::npos) {
+        submitLines();
+    }
+    return count;
+}
+
+int SharedOutputStreambuf::sync() { return 0; }
+
+void SharedOutputStreambuf::submitLines() {
+    size_t const end = pending.rfind('\n') + 1;
+    // Submit every line separately, so lines of other processes can be
+    // interleaved between them but never within them
+    size_t begin = 0;
+    while (begin < end) {
+        size_t const lineEnd = pending.find('\n', begin) + 1;
+        output.submit(std::string_view(pending).substr(begin, lineEnd - begin));
+        begin = lineEnd;
+    }
+    pending.erase(0, end);
+}
+
+static bool fdIsTerminal(int fd) {
+#if TFMT_UNIX
+    return isatty(fd);
+#elif TFMT_WINDOWS
+    return _isatty(fd);
+#endif
+}
+
+SharedOutputStream::SharedOutputStream(SharedOutput& output):
+    std::ostream(&buf), buf(output) {
+    setTermFormattable(*this, fdIsTerminal(output.fd()));
+}
@@ -0,0 +1,306 @@
+#include "termfmt/sixel.h"
+
+#include <algorithm>
+#include <cassert>
+#include <charconv>
+#include <ostream>
+
+#include "termfmt/termfmt.h"
+
+using namespace tfmt;
+
+/// Number of histogram buckets, five bits per channel
+static constexpr std::size_t NumBuckets = 1 << 15;
+
+/// Palette index of pixels that are not drawn
+static constexpr std::uint16_t Transparent = 0xFFFF;
+
+static std::uint16_t bucketKey(std::uint8_t const* pixel) {
+    return static_cast<std::uint16_t>((pixel[0] >> 3) << 10 |
+                                      (pixel[1] >> 3) << 5 | (pixel[2] >> 3));
+}
+
+/// \Returns the five bit value of channel \p channel of bucket \p key
+static unsigned bucketChannel(std::uint16_t key, int channel) {
+    return key >> (10 - 5 * channel) & 31;
+}
+
+/// Mixes the bits of \p x (splitmix64 finalizer), so that the sum of mixed
+/// keys identifies a set of keys
+static std::uint64_t mix(std::uint64_t x) {
+    x += 0x9E3779B97F4A7C15;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EB;
+    return x ^ (x >> 31);
+}
+
+static void appendNumber(std::string& out, std::size_t value) {
+    char buffer[24];
+    out.append(buffer,
+               std::to_chars(std::begin(buffer), std::end(buffer), value).ptr);
+}
+
+/// Appends \p count repetitions of the sixel \p sixel
+static void appendRun(std::string& out, char sixel, std::size_t count) {
+    // `!<count><sixel>` is shorter from four repetitions on
+    if (count >= 4) {
+        out += '!';
+        appendNumber(out, count);
+        out += sixel;
+    }
+    else {
+        out.append(count, sixel);
+    }
+}
+
+SixelEncoder::SixelEncoder(SixelOptions options):
+    options(options), slots(NumBuckets, -1) {
+    assert(options.maxColors >= 1 && options.maxColors <= 256);
+    // `current` points into the cache
+    cache.reserve(CacheSize);
+}
+
+void SixelEncoder::encode(SixelImage const& image, std::string& out) {
+    assert(image.channels == 3 || image.channels == 4);
+    assert(image.pixels.size() >= image.width * image.height * image.channels);
+    current = &quantize(image);
+    out += "\033P0;1;0q\"1;1;";
+    appendNumber(out, image.width);
+    out += ';';
+    appendNumber(out, image.height);
+    // Colors are given in percent
+    auto percent = [](std::uint32_t value) {
+        return (static_cast<std::size_t>(value & 0xFF) * 100 + 127) / 255;
+    };
+    for (std::size_t i = 0; i < current->colors.size(); ++i) {
+        std::uint32_t const color = current->colors[i];
+        out += '#';
+        appendNumber(out, i);
+        out += ";2;";
+        appendNumber(out, percent(color >> 16));
+        out += ';';
+        appendNumber(out, percent(color >> 8));
+        out += ';';
+        appendNumber(out, percent(color));
+    }
+    appendData(image.width, image.height, out);
+    out += "\033\\";
+}
+
+void SixelEncoder::write(std::ostream& ostream, SixelImage const& image) {
+    if (!isTermFormattable(ostream)) {
+        return;
+    }
+    buffer.clear();
+    encode(image, buffer);
+    ostream.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+}
+
+std::span<std::uint32_t const> SixelEncoder::palette() const {
+    if (!current) {
+        return {};
+    }
+    return current->colors;
+}
+
+SixelEncoder::Palette const& SixelEncoder::quantize(SixelImage const& image) {
+    std::size_t const numPixels = image.width * image.height;
+    indices.resize(numPixels);
+    buckets.clear();
+    std::uint64_t signature = 0;
+    for (std::size_t i = 0; i < numPixels; ++i) {
+        std::uint8_t const* pixel = image.pixels.data() + i * image.channels;
+        if (image.channels == 4 && pixel[3] < options.alphaThreshold) {
+            indices[i] = Transparent;
+            continue;
+        }
+        std::uint16_t const key = bucketKey(pixel);
+        std::int32_t slot = slots[key];
+        if (slot < 0) {
+            slot = static_cast<std::int32_t>(buckets.size());
+            slots[key] = slot;
+            buckets.push_back({ key, 0, 0, 0, 0 });
+            signature += mix(key);
+        }
+        auto& bucket = buckets[static_cast<std::size_t>(slot)];
+        ++bucket.count;
+        bucket.red += pixel[0];
+        bucket.green += pixel[1];
+        bucket.blue += pixel[2];
+        // Replaced by the palette index below
+        indices[i] = key;
+    }
+    for (auto const& bucket: buckets) {
+        slots[bucket.key] = -1;
+    }
+    Palette* palette = nullptr;
+    for (auto& entry: cache) {
+        if (entry.signature == signature) {
+            palette = &entry;
+            ++numCacheHits;
+            break;
+        }
+    }
+    if (!palette) {
+        if (cache.size() < CacheSize) {
+            palette = &cache.emplace_back();
+        }
+        else {
+            palette = &cache[nextEvicted];
+            nextEvicted = (nextEvicted + 1) % CacheSize;
+        }
+        palette->signature = signature;
+        medianCut(*palette);
+    }
+    for (auto& index: indices) {
+        if (index != Transparent) {
+            index = palette->lookup[index];
+        }
+    }
+    return *palette;
+}
+
+void SixelEncoder::medianCut(Palette& palette) {
+    struct Box {
+        std::size_t begin, end;
+        /// Channel with the largest range of values and the range
+        int channel;
+        unsigned range;
+    };
+    auto makeBox = [&](std::size_t begin, std::size_t end) {
+        Box box{ begin, end, 0, 0 };
+        for (int channel = 0; channel < 3; ++channel) {
+            auto [min, max] = std::minmax_element(
+                buckets.begin() + static_cast<std::ptrdiff_t>(begin),
+                buckets.begin() + static_cast<std::ptrdiff_t>(end),
+                [&](Bucket const& a, Bucket const& b) {
+                return bucketChannel(a.key, channel) <
+                       bucketChannel(b.key, channel);
+            });
+            unsigned const range = bucketChannel(max->key, channel) -
+                                   bucketChannel(min->key, channel);
+            if (range >= box.range) {
+                box.channel = channel;
+                box.range = range;
+            }
+        }
+        return box;
+    };
+    std::vector<Box> boxes;
+    if (!buckets.empty()) {
+        boxes.push_back(makeBox(0, buckets.size()));
+    }
+    while (!boxes.empty() && boxes.size() < options.maxColors) {
+        // Split the box with the largest range
+        auto box = std::max_element(boxes.begin(),
+                                    boxes.end(),
+                                    [](Box const& a, Box const& b) {
+            return a.range < b.range;
+        });
+        if (box->range == 0) {
+            break;
+        }
+        auto const first =
+            buckets.begin() + static_cast<std::ptrdiff_t>(box->begin);
+        auto const last =
+            buckets.begin() + static_cast<std::ptrdiff_t>(box->end);
+        int const channel = box->channel;
+        std::sort(first, last, [&](Bucket const& a, Bucket const& b) {
+            return bucketChannel(a.key, channel) <
+                   bucketChannel(b.key, channel);
+        });
+        // Split at the median pixel, so both halves hold about the same
+        // number of pixels
+        std::uint64_t total = 0;
+        for (auto itr = first; itr != last; ++itr) {
+            total += itr->count;
+        }
+        std::size_t split = box->begin + 1;
+        std::uint64_t count = first->count;
+        while (split + 1 < box->end && 2 * count < total) {
+            count += buckets[split].count;
+            ++split;
+        }
+        std::size_t const end = box->end;
+        *box = makeBox(box->begin, split);
+        boxes.push_back(makeBox(split, end));
+    }
+    palette.colors.clear();
+    palette.lookup.assign(NumBuckets, 0);
+    for (auto const& box: boxes) {
+        std::uint64_t count = 0, red = 0, green = 0, blue = 0;
+        for (std::size_t i = box.begin; i < box.end; ++i) {
+            auto const& bucket = buckets[i];
+            count += bucket.count;
+            red += bucket.red;
+            green += bucket.green;
+            blue += bucket.blue;
+            palette.lookup[bucket.key] =
+                static_cast<std::uint16_t>(palette.colors.size());
+        }
+        auto mean = [&](std::uint64_t sum) {
+            return static_cast<std::uint32_t>((sum + count / 2) / count);
+        };
+        palette.colors.push_back(mean(red) << 16 | mean(green) << 8 |
+                                 mean(blue));
+    }
+}
+
+void SixelEncoder::appendData(std::size_t width,
+                              std::size_t height,
+                              std::string& out) {
+    bandSlots.assign(current->colors.size(), -1);
+    for (std::size_t top = 0; top < height; top += 6) {
+        std::size_t const rows = std::min<std::size_t>(6, height - top);
+        std::uint16_t const* band = indices.data() + top * width;
+        // Collect the colors of the band
+        bandColors.clear();
+        for (std::size_t i = 0; i < rows * width; ++i) {
+            std::uint16_t const index = band[i];
+            if (index != Transparent && bandSlots[index] < 0) {
+                bandSlots[index] = static_cast<std::int32_t>(bandColors.size());
+                bandColors.push_back(index);
+            }
+        }
+        // One row of sixels per color, each sixel holding six pixels in its
+        // bits from top to bottom
+        bandBits.assign(bandColors.size() * width, 0);
+        for (std::size_t row = 0; row < rows; ++row) {
+            for (std::size_t x = 0; x < width; ++x) {
+                std::uint16_t const index = band[row * width + x];
+                if (index == Transparent) {
+                    continue;
+                }
+                auto const slot = static_cast<std::size_t>(bandSlots[index]);
+                bandBits[slot * width + x] |=
+                    static_cast<std::uint8_t>(1 << row);
+            }
+        }
+        for (std::size_t slot = 0; slot < bandColors.size(); ++slot) {
+            if (slot > 0) {
+                // Carriage return to paint the next color over the band
+                out += '$';
+            }
+            out += '#';
+            appendNumber(out, bandColors[slot]);
+            std::uint8_t const* bits = bandBits.data() + slot * width;
+            std::size_t end = width;
+            while (end > 0 && bits[end - 1] == 0) {
+                --end;
+            }
+            for (std::size_t x = 0; x < end;) {
+                std::size_t runEnd = x + 1;
+                while (runEnd < end && bits[runEnd] == bits[x]) {
+                    ++runEnd;
+                }
+                appendRun(out, static_cast<char>('?' + bits[x]), runEnd - x);
+                x = runEnd;
+            }
+            bandSlots[bandColors[slot]] = -1;
+        }
+        if (top + 6 < height) {
+            // Next band
+            out += '-';
+        }
+    }
+}
@@ -0,0 +1,143 @@
+#include "termfmt/string_stream.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <locale>
+#include <memory>
+#include <streambuf>
+#include <vector>
+
+#include "termfmt/termfmt.h"
+
+using namespace tfmt;
+
+/// Maximum number of idle streams per thread
+static constexpr std::size_t MaxPoolSize = 16;
+
+/// Buffers larger than this are released when their stream is returned to the
+/// pool, so one long line does not pin its memory
+static constexpr std::size_t MaxRetainedCapacity = 1 << 16;
+
+namespace {
+
+/// Stream buffer that writes into a string whose capacity is reused
+class StringStreambuf: public std::streambuf {
+public:
+    std::string_view view() const {
+        return std::string_view(pbase(),
+                                static_cast<std::size_t>(pptr() - pbase()));
+    }
+
+    void clear() {
+        if (buffer.size() > MaxRetainedCapacity) {
+            buffer = std::string();
+        }
+        setPutArea(0);
+    }
+
+protected:
+    int_type overflow(int_type ch) override {
+        if (traits_type::eq_int_type(ch, traits_type::eof())) {
+            return traits_type::not_eof(ch);
+        }
+        reserve(1);
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+        return ch;
+    }
+
+    std::streamsize xsputn(char const* data, std::streamsize count) override {
+        auto const size = static_cast<std::size_t>(count);
+        reserve(size);
+        std::memcpy(pptr(), data, size);
+        setPutArea(static_cast<std::size_t>(pptr() - pbase()) + size);
+        return count;
+    }
+
+private:
+    /// Make room for \p count more characters
+    void reserve(std::size_t count) {
+        if (static_cast<std::size_t>(epptr() - pptr()) >= count) {
+            return;
+        }
+        std::size_t const used = static_cast<std::size_t>(pptr() - pbase());
+        buffer.resize(std::max({ used + count, 2 * buffer.size(),
+                                 std::size_t{ 256 } }));
+        setPutArea(used);
+    }
+
+    /// Put area over the whole buffer with \p used characters written
+    void setPutArea(std::size_t used) {
+        setp(buffer.data(), buffer.data() + buffer.size());
+        // `pbump()` takes an `int`
+        while (used > INT_MAX) {
+            pbump(INT_MAX);
+            used -= INT_MAX;
+        }
+        pbump(static_cast<int>(used));
+    }
+
+    std::string buffer;
+};
+
+} // namespace
+
+class tfmt::internal::PooledStream: public std::ostream {
+public:
+    PooledStream():
+        std::ostream(&buf), defaultFlags(flags()), defaultLocale(getloc()) {
+        setTermFormattable(*this);
+    }
+
+    std::string_view view() const { return buf.view(); }
+
+    /// Clear the text and restore the initial state
+    void reset() {
+        buf.clear();
+        exceptions(std::ios_base::goodbit);
+        clear();
+        if (getloc() != defaultLocale) {
+            imbue(defaultLocale);
+        }
+        // Modifiers that were not popped must not affect the next use
+        internal::clearModifiers(*this);
+        flags(defaultFlags);
+        width(0);
+        precision(6);
+        fill(' ');
+        setTermFormattable(*this);
+        setHTMLFormattable(*this, false);
+        setSVGFormattable(*this, false);
+        setWidth(*this, 0);
+    }
+
+private:
+    StringStreambuf buf;
+    std::ios_base::fmtflags defaultFlags;
+    std::locale defaultLocale;
+};
+
+static thread_local std::vector<std::unique_ptr<internal::PooledStream>> pool;
+
+PooledStringStream::PooledStringStream() {
+    if (pool.empty()) {
+        impl = new internal::PooledStream();
+        return;
+    }
+    impl = pool.back().release();
+    pool.pop_back();
+}
+
+PooledStringStream::~PooledStringStream() {
+    if (pool.size() >= MaxPoolSize) {
+        delete impl;
+        return;
+    }
+    impl->reset();
+    pool.emplace_back(impl);
+}
+
+std::ostream& PooledStringStream::stream() { return *impl; }
+
+std::string_view PooledStringStream::view() const { return impl->view(); }
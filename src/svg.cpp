@@ -0,0 +1,482 @@
+#include "termfmt/svg.h"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "termfmt/ansi.h"
+#include "termfmt/grapheme.h"
+#include "termfmt/termfmt.h"
+
+using namespace tfmt;
+
+namespace {
+
+using internal::Attributes;
+
+/// Resolved colors are stored as `0xRRGGBB` with `Color::Set` set. Zero means
+/// default.
+enum Color : std::uint32_t { Default = 0, Set = 1u << 24 };
+
+/// Approximation of the xterm default palette
+constexpr std::array<std::uint32_t, 16> BasicPalette = {
+    0x000000, 0xCD3131, 0x0DBC79, 0xE5E510, 0x2472C8, 0xBC3FBC,
+    0x11A8CD, 0xE5E5E5, 0x666666, 0xF14C4C, 0x23D18B, 0xF5F543,
+    0x3B8EEA, 0xD670D6, 0x29B8DB, 0xFFFFFF,
+};
+
+std::uint32_t paletteColor(unsigned index) {
+    if (index < 16) {
+        return Set | BasicPalette[index];
+    }
+    if (index < 232) {
+        static constexpr std::uint32_t Levels[] = { 0, 95, 135, 175, 215, 255 };
+        index -= 16;
+        return Set | Levels[index / 36] << 16 | Levels[index / 6 % 6] << 8 |
+               Levels[index % 6];
+    }
+    std::uint32_t const grey = 8 + 10 * (std::min(index, 255u) - 232);
+    return Set | grey << 16 | grey << 8 | grey;
+}
+
+/// \Returns the RGB value of the color \p color of `Attributes`
+std::uint32_t resolveColor(std::uint32_t color) {
+    std::uint32_t const value = color & 0xFFFFFF;
+    switch (Attributes::colorKind(color)) {
+    case Attributes::BasicColor:
+        // Foreground and background codes of normal and bright colors
+        if (value >= 90) {
+            return paletteColor(value % 10 + 8);
+        }
+        return paletteColor(value % 10);
+    case Attributes::IndexedColor: return paletteColor(value);
+    case Attributes::RGBColor: return Set | value;
+    default: return Default;
+    }
+}
+
+/// \Returns the number of bytes at the end of \p text that begin a UTF-8
+/// encoded code point without completing it
+size_t incompleteSuffix(std::string_view text) {
+    size_t const max = std::min<size_t>(3, text.size());
+    for (size_t count = 1; count <= max; ++count) {
+        auto const uc = static_cast<unsigned char>(text[text.size() - count]);
+        if ((uc & 0xC0) == 0x80) {
+            continue;
+        }
+        size_t const length = uc >= 0xF0 ? 4 :
+                                   uc >= 0xE0 ? 3 :
+                                   uc >= 0xC0 ? 2 :
+                                                1;
+        return length > count ? count : 0;
+    }
+    return 0;
+}
+
+} // namespace
+
+/// Streaming state machine translating ANSI text to SVG
+class tfmt::internal::SVGRenderer {
+public:
+    explicit SVGRenderer(std::ostream& dest, SVGOptions options):
+        dest(dest),
+        options(std::move(options)),
+        charWidth(0.6 * this->options.fontSize),
+        lineHeight(1.25 * this->options.fontSize) {
+        writeHeader();
+    }
+
+    void write(std::string_view text) {
+        if (finished) {
+            return;
+        }
+        parser.feed(text);
+        while (auto event = parser.next()) {
+            if (event->kind == AnsiEventKind::Text) {
+                putText(event->text);
+                continue;
+            }
+            // Only text continues a grapheme cluster
+            putCluster(pendingCluster);
+            pendingCluster.clear();
+            switch (event->kind) {
+            case AnsiEventKind::Control:
+                putControl(event->final);
+                break;
+            case AnsiEventKind::Style:
+                internal::applySGR(style, event->params, event->subparams);
+                // Runs are compared by the attributes in effect
+                style.reset = false;
+                break;
+            default:
+                break;
+            }
+        }
+        if (out.size() >= FlushThreshold) {
+            flushOutput();
+        }
+    }
+
+    void sync() {
+        flushOutput();
+        dest.flush();
+    }
+
+    void finish();
+
+private:
+    static constexpr size_t FlushThreshold = 1 << 12;
+    /// Size of the escaped text of a run at which it is written, so long
+    /// lines in one style are not held in memory
+    static constexpr size_t MaxRunSize = 1 << 12;
+
+    void putText(std::string_view text);
+    void putCluster(std::string_view cluster);
+    void putControl(char c);
+    void newline();
+    void flushRun();
+    void writeHeader();
+    void writePlaceholder(std::streampos& pos);
+    void patchPlaceholder(std::streampos pos, double value);
+    void flushOutput();
+
+    void putNumber(double value) {
+        char buffer[32];
+        char* end = std::to_chars(std::begin(buffer),
+                                  std::end(buffer),
+                                  value,
+                                  std::chars_format::fixed,
+                                  2)
+                        .ptr;
+        // Trim trailing zeros
+        while (end[-1] == '0') {
+            --end;
+        }
+        if (end[-1] == '.') {
+            --end;
+        }
+        out.append(buffer, end);
+    }
+
+    void putColor(std::uint32_t color) {
+        static constexpr char Digits[] = "0123456789abcdef";
+        out += '#';
+        for (int shift = 20; shift >= 0; shift -= 4) {
+            out += Digits[(color >> shift) & 0xF];
+        }
+    }
+
+    std::ostream& dest;
+    SVGOptions options;
+    double charWidth;
+    double lineHeight;
+
+    /// Generated SVG that has not been written to `dest` yet
+    std::string out;
+
+    AnsiParser parser;
+
+    Attributes style;
+    Attributes runStyle;
+    /// Last grapheme cluster of the text so far, which may continue in the
+    /// next chunk
+    std::string pendingCluster;
+    /// XML escaped text of the current run
+    std::string run;
+    size_t runColumn = 0;
+    size_t runWidth = 0;
+
+    size_t line = 0;
+    size_t column = 0;
+    size_t maxColumn = 0;
+
+    std::streampos widthPos = -1, heightPos = -1;
+    std::streampos viewBoxWidthPos = -1, viewBoxHeightPos = -1;
+    bool finished = false;
+};
+
+using internal::SVGRenderer;
+
+void SVGRenderer::putText(std::string_view text) {
+    bool const buffered = !pendingCluster.empty();
+    std::string_view rest = text;
+    if (buffered) {
+        pendingCluster += text;
+        rest = pendingCluster;
+    }
+    // The last cluster and a code point split at the end of the chunk stay
+    // pending
+    size_t const tail = incompleteSuffix(rest);
+    while (true) {
+        Grapheme const grapheme =
+            nextGrapheme(rest.substr(0, rest.size() - tail));
+        if (grapheme.size == rest.size() - tail) {
+            break;
+        }
+        putCluster(rest.substr(0, grapheme.size));
+        rest.remove_prefix(grapheme.size);
+    }
+    if (buffered) {
+        pendingCluster.erase(0, pendingCluster.size() - rest.size());
+    }
+    else {
+        pendingCluster.assign(rest);
+    }
+}
+
+void SVGRenderer::putCluster(std::string_view cluster) {
+    if (cluster.empty()) {
+        return;
+    }
+    if (style != runStyle) {
+        flushRun();
+        runStyle = style;
+    }
+    if (run.empty() && runWidth == 0) {
+        runColumn = column;
+    }
+    // Wide characters take two columns and marks combine with their base
+    size_t const width = displayWidth(cluster);
+    column += width;
+    runWidth += width;
+    maxColumn = std::max(maxColumn, column);
+    if (runStyle.flags & Attributes::Concealed) {
+        return;
+    }
+    for (char const c: cluster) {
+        switch (c) {
+        case '&': run += "&amp;"; break;
+        case '<': run += "&lt;"; break;
+        case '>': run += "&gt;"; break;
+        default: run += c; break;
+        }
+    }
+    if (run.size() >= MaxRunSize) {
+        flushRun();
+    }
+}
+
+void SVGRenderer::putControl(char c) {
+    switch (c) {
+    case '\n':
+        newline();
+        return;
+    case '\r':
+        flushRun();
+        column = 0;
+        return;
+    case '\t': {
+        flushRun();
+        column = (column / 8 + 1) * 8;
+        maxColumn = std::max(maxColumn, column);
+        return;
+    }
+    default:
+        // Other control characters don't render
+        return;
+    }
+}
+
+void SVGRenderer::newline() {
+    flushRun();
+    ++line;
+    column = 0;
+}
+
+void SVGRenderer::flushRun() {
+    if (runWidth == 0) {
+        // Zero width characters without a base can't be placed
+        run.clear();
+        return;
+    }
+    std::uint32_t fg = resolveColor(runStyle.fg);
+    std::uint32_t bg = resolveColor(runStyle.bg);
+    if (runStyle.flags & Attributes::Inverse) {
+        std::swap(fg, bg);
+        auto parseHex = [](std::string const& hex) -> std::uint32_t {
+            std::uint32_t value = 0;
+            if (hex.size() == 7 && hex[0] == '#') {
+                std::from_chars(hex.data() + 1, hex.data() + 7, value, 16);
+            }
+            return Set | value;
+        };
+        if (fg == Default) {
+            fg = parseHex(options.background);
+        }
+        if (bg == Default) {
+            bg = parseHex(options.foreground);
+        }
+    }
+    double const x = static_cast<double>(runColumn) * charWidth;
+    double const width = static_cast<double>(runWidth) * charWidth;
+    if (bg != Default) {
+        out += "<rect x=\"";
+        putNumber(x);
+        out += "\" y=\"";
+        putNumber(static_cast<double>(line) * lineHeight);
+        out += "\" width=\"";
+        putNumber(width);
+        out += "\" height=\"";
+        putNumber(lineHeight);
+        out += "\" fill=\"";
+        putColor(bg);
+        out += "\"/>\n";
+    }
+    if (!run.empty()) {
+        out += "<text x=\"";
+        putNumber(x);
+        out += "\" y=\"";
+        // Baseline of the line
+        putNumber(static_cast<double>(line + 1) * lineHeight -
+                  0.3 * options.fontSize);
+        out += "\" textLength=\"";
+        putNumber(width);
+        out += '"';
+        if (fg != Default) {
+            out += " fill=\"";
+            putColor(fg);
+            out += '"';
+        }
+        auto const flags = runStyle.flags;
+        if (flags & Attributes::Bold) {
+            out += " font-weight=\"bold\"";
+        }
+        if (flags & Attributes::Dim) {
+            out += " fill-opacity=\"0.6\"";
+        }
+        if (flags & Attributes::Italic) {
+            out += " font-style=\"italic\"";
+        }
+        bool const underline = flags & Attributes::Underline;
+        bool const crossed = flags & Attributes::Crossed;
+        if (underline || crossed) {
+            out += " text-decoration=\"";
+            out += underline ? "underline" : "";
+            out += underline && crossed ? " " : "";
+            out += crossed ? "line-through" : "";
+            out += '"';
+        }
+        out += '>';
+        out += run;
+        out += "</text>\n";
+    }
+    run.clear();
+    runWidth = 0;
+}
+
+void SVGRenderer::writePlaceholder(std::streampos& pos) {
+    flushOutput();
+    pos = dest.tellp();
+    if (pos == std::streampos(-1)) {
+        out += "100%";
+    }
+    else {
+        out += "0000000000";
+    }
+}
+
+void SVGRenderer::patchPlaceholder(std::streampos pos, double value) {
+    if (pos == std::streampos(-1)) {
+        return;
+    }
+    char buffer[16];
+    auto const number = std::lround(std::ceil(value));
+    char* end = std::to_chars(std::begin(buffer), std::end(buffer), number).ptr;
+    std::string text(10 - std::min<size_t>(10, end - buffer), '0');
+    text.append(buffer, end);
+    dest.seekp(pos);
+    dest.write(text.data(), 10);
+}
+
+void SVGRenderer::writeHeader() {
+    out += "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"";
+    writePlaceholder(widthPos);
+    out += "\" height=\"";
+    writePlaceholder(heightPos);
+    out += '"';
+    if (widthPos != std::streampos(-1)) {
+        out += " viewBox=\"0 0 ";
+        writePlaceholder(viewBoxWidthPos);
+        out += ' ';
+        writePlaceholder(viewBoxHeightPos);
+        out += '"';
+    }
+    out += ">\n<rect width=\"100%\" height=\"100%\" fill=\"";
+    out += options.background;
+    out += "\"/>\n<g font-family=\"";
+    out += options.fontFamily;
+    out += "\" font-size=\"";
+    putNumber(options.fontSize);
+    out += "\" fill=\"";
+    out += options.foreground;
+    out += "\" xml:space=\"preserve\" style=\"white-space:pre\">\n";
+}
+
+void SVGRenderer::flushOutput() {
+    dest.write(out.data(), static_cast<std::streamsize>(out.size()));
+    out.clear();
+}
+
+void SVGRenderer::finish() {
+    if (finished) {
+        return;
+    }
+    finished = true;
+    putCluster(pendingCluster);
+    pendingCluster.clear();
+    flushRun();
+    out += "</g>\n</svg>\n";
+    flushOutput();
+    size_t const lines = line + (column > 0 ? 1 : 0);
+    double const width = static_cast<double>(maxColumn) * charWidth;
+    double const height = static_cast<double>(lines) * lineHeight;
+    auto const end = dest.tellp();
+    patchPlaceholder(widthPos, width);
+    patchPlaceholder(heightPos, height);
+    patchPlaceholder(viewBoxWidthPos, width);
+    patchPlaceholder(viewBoxHeightPos, height);
+    if (end != std::streampos(-1)) {
+        dest.seekp(end);
+    }
+    dest.flush();
+}
+
+SVGStreambuf::SVGStreambuf(std::ostream& dest, SVGOptions options):
+    renderer(std::make_unique<SVGRenderer>(dest, std::move(options))) {}
+
+SVGStreambuf::~SVGStreambuf() { finish(); }
+
+void SVGStreambuf::finish() { renderer->finish(); }
+
+SVGStreambuf::int_type SVGStreambuf::overflow(int_type ch) {
+    if (traits_type::eq_int_type(ch, traits_type::eof())) {
+        return traits_type::not_eof(ch);
+    }
+    char const c = traits_type::to_char_type(ch);
+    renderer->write(std::string_view(&c, 1));
+    return ch;
+}
+
+std::streamsize SVGStreambuf::xsputn(char const* data, std::streamsize count) {
+    renderer->write(std::string_view(data, static_cast<size_t>(count)));
+    return count;
+}
+
+int SVGStreambuf::sync() {
+    renderer->sync();
+    return 0;
+}
+
+SVGStream::SVGStream(std::ostream& dest, SVGOptions options):
+    std::ostream(&buf), buf(dest, std::move(options)) {
+    setSVGFormattable(*this);
+}
+
+void SVGStream::finish() {
+    flush();
+    buf.finish();
+}
@@ -0,0 +1,212 @@
+#include "termfmt/table.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <optional>
+
+#include "termfmt/tabs.h"
+#include "termfmt/termfmt.h"
+
+using namespace tfmt;
+
+TableWriter::TableWriter(std::ostream& ostream,
+                         std::vector<std::string> header,
+                         TableOptions options):
+    ostream(ostream), options(options), header(std::move(header)) {
+    if (options.tabWidth > 0) {
+        for (auto& cell: this->header) {
+            if (cell.find('\t') != std::string::npos) {
+                cell = tfmt::expandTabs(cell, { .tabWidth = options.tabWidth });
+            }
+        }
+    }
+    sample.reserve(std::min<std::size_t>(options.sampleSize, 1024));
+}
+
+TableWriter::~TableWriter() { finish(); }
+
+void TableWriter::addRow(std::span<std::string_view const> cells) {
+    cells = expandTabs(cells);
+    if (isLaidOut) {
+        putRow(cells);
+        return;
+    }
+    sample.emplace_back(cells.begin(), cells.end());
+    if (sample.size() >= options.sampleSize) {
+        layout();
+    }
+}
+
+std::span<std::string_view const> TableWriter::expandTabs(
+    std::span<std::string_view const> cells) {
+    bool const hasTabs =
+        options.tabWidth > 0 &&
+        std::any_of(cells.begin(), cells.end(), [](std::string_view cell) {
+            return cell.find('\t') != std::string_view::npos;
+        });
+    if (!hasTabs) {
+        return cells;
+    }
+    expandedCells.resize(cells.size());
+    expandedViews.resize(cells.size());
+    for (std::size_t i = 0; i < cells.size(); ++i) {
+        expandedCells[i].clear();
+        TabExpander({ .tabWidth = options.tabWidth })
+            .expand(cells[i], expandedCells[i]);
+        expandedViews[i] = expandedCells[i];
+    }
+    return expandedViews;
+}
+
+void TableWriter::finish() {
+    if (!isLaidOut) {
+        layout();
+    }
+}
+
+void TableWriter::layout() {
+    isLaidOut = true;
+    std::size_t numColumns = header.size();
+    if (numColumns == 0) {
+        for (auto& row: sample) {
+            numColumns = std::max(numColumns, row.size());
+        }
+    }
+    widths.assign(numColumns, 0);
+    auto measure = [&](std::span<std::string const> row) {
+        for (std::size_t i = 0; i < std::min(row.size(), numColumns); ++i) {
+            widths[i] = std::max(widths[i], displayWidth(row[i]));
+        }
+    };
+    measure(header);
+    for (auto& row: sample) {
+        measure(row);
+    }
+    if (options.maxColumnWidth > 0) {
+        for (auto& width: widths) {
+            width = std::min(width, options.maxColumnWidth);
+        }
+    }
+    fitToWidth();
+    if (!header.empty()) {
+        putRow(header, /* isHeader = */ true);
+    }
+    for (auto& row: sample) {
+        putRow(row, /* isHeader = */ false);
+    }
+    // Release the window, from now on rows are printed as they arrive
+    sample = {};
+    header = {};
+}
+
+void TableWriter::fitToWidth() {
+    if (options.maxTableWidth == 0 || widths.empty() ||
+        options.overflow == TableOverflow::Expand)
+    {
+        return;
+    }
+    std::size_t const separators =
+        options.separator.size() * (widths.size() - 1);
+    if (options.maxTableWidth <= separators) {
+        return;
+    }
+    std::size_t const available = options.maxTableWidth - separators;
+    auto totalWidth = [&](std::size_t cap) {
+        std::size_t total = 0;
+        for (auto width: widths) {
+            total += std::min(width, cap);
+        }
+        return total;
+    };
+    if (totalWidth(SIZE_MAX) <= available) {
+        return;
+    }
+    // Find the largest cap that fits by bisection, so narrow columns stay
+    // intact and only the widest ones are cut
+    std::size_t low = 1;
+    std::size_t high = *std::max_element(widths.begin(), widths.end());
+    while (low < high) {
+        std::size_t const mid = (low + high + 1) / 2;
+        if (totalWidth(mid) <= available) {
+            low = mid;
+        }
+        else {
+            high = mid - 1;
+        }
+    }
+    for (auto& width: widths) {
+        width = std::min(width, low);
+    }
+}
+
+void TableWriter::putRow(std::span<std::string const> cells, bool isHeader) {
+    line.clear();
+    for (std::size_t i = 0; i < widths.size(); ++i) {
+        appendCell(i < cells.size() ? std::string_view(cells[i]) : "", i);
+    }
+    writeLine(isHeader);
+}
+
+void TableWriter::putRow(std::span<std::string_view const> cells) {
+    line.clear();
+    for (std::size_t i = 0; i < widths.size(); ++i) {
+        appendCell(i < cells.size() ? cells[i] : "", i);
+    }
+    writeLine(/* isHeader = */ false);
+}
+
+void TableWriter::appendCell(std::string_view cell, std::size_t column) {
+    if (column > 0) {
+        line += options.separator;
+    }
+    std::size_t const width = displayWidth(cell);
+    std::size_t& columnWidth = widths[column];
+    bool const truncated =
+        width > columnWidth && options.overflow == TableOverflow::Truncate;
+    if (!truncated) {
+        columnWidth = std::max(columnWidth, width);
+    }
+    std::string_view text = cell;
+    std::size_t used = width;
+    if (truncated) {
+        text = columnWidth > 0 ? truncateToWidth(cell, columnWidth - 1) : "";
+        used = columnWidth > 0 ? displayWidth(text) + 1 : 0;
+    }
+    bool const rightAligned = column < options.alignment.size() &&
+                              options.alignment[column] == TableAlign::Right;
+    if (rightAligned) {
+        line.append(columnWidth - used, ' ');
+    }
+    line += text;
+    if (truncated && columnWidth > 0) {
+        line += internal::Ellipsis;
+        if (text.find('\033') != std::string_view::npos) {
+            // The cell may have been cut before its formatting was undone
+            line += Reset.ansiBuffer();
+            needsReapply = true;
+        }
+    }
+    // The last column is not padded to avoid trailing whitespace
+    if (!rightAligned && column + 1 < widths.size()) {
+        line.append(columnWidth - used, ' ');
+    }
+}
+
+void TableWriter::writeLine(bool isHeader) {
+    // Trim trailing whitespace of empty trailing cells
+    line.erase(line.find_last_not_of(' ') + 1);
+    {
+        std::optional<internal::ModifierRefGuard<char, std::char_traits<char>>>
+            guard;
+        if (isHeader && options.headerModifier) {
+            guard.emplace(*options.headerModifier, ostream);
+        }
+        ostream.write(line.data(), static_cast<std::streamsize>(line.size()));
+    }
+    if (needsReapply) {
+        reapplyModifiers(ostream);
+        needsReapply = false;
+    }
+    ostream.put('\n');
+}
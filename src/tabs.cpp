@@ -0,0 +1,172 @@
+#include "termfmt/tabs.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "termfmt/ansi.h"
+#include "termfmt/grapheme.h"
+#include "termfmt/termfmt.h"
+
+using namespace tfmt;
+
+/// Size above which the unmeasured part of a long line without tabs is
+/// measured early, so that `pending` stays bounded
+static constexpr std::size_t MaxPendingSize = 4096;
+
+TabExpander::TabExpander(TabOptions options):
+    tabWidth(options.tabWidth),
+    stops(options.stops.begin(), options.stops.end()) {
+    assert(tabWidth > 0 && "Tab width must not be zero");
+    assert(std::is_sorted(stops.begin(), stops.end()));
+}
+
+void TabExpander::expand(std::string_view chunk, std::string& out) {
+    while (!chunk.empty()) {
+        std::size_t const tab = chunk.find('\t');
+        auto const run = chunk.substr(0, tab);
+        out += run;
+        // Only the text after the last line break or carriage return
+        // determines the column
+        std::size_t const newline = run.find_last_of("\n\r");
+        if (newline != std::string_view::npos) {
+            currentColumn = 0;
+            pending.assign(run.substr(newline + 1));
+        }
+        else {
+            pending += run;
+        }
+        if (tab == std::string_view::npos) {
+            boundPending();
+            return;
+        }
+        measurePending();
+        std::size_t const stop = nextStop(currentColumn);
+        out.append(stop - currentColumn, ' ');
+        currentColumn = stop;
+        chunk.remove_prefix(tab + 1);
+    }
+}
+
+std::size_t TabExpander::column() const {
+    return currentColumn + displayWidth(pending);
+}
+
+void TabExpander::reset() {
+    currentColumn = 0;
+    pending.clear();
+}
+
+std::size_t TabExpander::nextStop(std::size_t column) const {
+    auto const stop = std::upper_bound(stops.begin(), stops.end(), column);
+    if (stop != stops.end()) {
+        return *stop;
+    }
+    std::size_t const base = stops.empty() ? 0 : stops.back();
+    return base + ((column - base) / tabWidth + 1) * tabWidth;
+}
+
+void TabExpander::measurePending() {
+    currentColumn += displayWidth(pending);
+    pending.clear();
+}
+
+/// \Returns the offset of the last grapheme cluster of \p text
+static std::size_t lastClusterBegin(std::string_view text) {
+    // Two ASCII characters always belong to different clusters, and control
+    // characters like CR are not part of text runs
+    for (std::size_t i = text.size(); i-- > 1;) {
+        if (static_cast<unsigned char>(text[i]) < 0x80 &&
+            static_cast<unsigned char>(text[i - 1]) < 0x80)
+        {
+            return i;
+        }
+    }
+    std::size_t begin = 0;
+    std::size_t offset = 0;
+    forEachGrapheme(text, [&](std::string_view cluster, std::size_t) {
+        begin = offset;
+        offset += cluster.size();
+    });
+    return begin;
+}
+
+void TabExpander::boundPending() {
+    if (pending.size() <= MaxPendingSize) {
+        return;
+    }
+    // Measure up to the end of the last complete escape sequence or the last
+    // grapheme cluster after it, whichever is later. The chunk may end within
+    // either, so the rest stays pending.
+    AnsiParser parser;
+    parser.feed(pending);
+    std::size_t cut = 0;
+    std::size_t textEnd = 0;
+    while (auto event = parser.next()) {
+        if (event->kind == AnsiEventKind::Text) {
+            textEnd = static_cast<std::size_t>(event->text.data() -
+                                               pending.data()) +
+                      event->text.size();
+        }
+        else {
+            cut = parser.consumed();
+        }
+    }
+    if (textEnd > cut) {
+        cut += lastClusterBegin(
+            std::string_view(pending).substr(cut, textEnd - cut));
+    }
+    currentColumn += displayWidth(std::string_view(pending).substr(0, cut));
+    pending.erase(0, cut);
+}
+
+std::string tfmt::expandTabs(std::string_view text, TabOptions const& options) {
+    std::string out;
+    out.reserve(text.size());
+    TabExpander(options).expand(text, out);
+    return out;
+}
+
+TabStreambuf::TabStreambuf(std::ostream& dest, TabOptions options):
+    dest(dest), expander(options) {
+    setp(buffer.data(), buffer.data() + buffer.size());
+}
+
+TabStreambuf::~TabStreambuf() { drain(); }
+
+TabStreambuf::int_type TabStreambuf::overflow(int_type ch) {
+    drain();
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+    return traits_type::not_eof(ch);
+}
+
+std::streamsize TabStreambuf::xsputn(char const* data, std::streamsize count) {
+    drain();
+    write(std::string_view(data, static_cast<std::size_t>(count)));
+    return count;
+}
+
+int TabStreambuf::sync() {
+    drain();
+    dest.flush();
+    return 0;
+}
+
+void TabStreambuf::write(std::string_view text) {
+    expanded.clear();
+    expander.expand(text, expanded);
+    dest.write(expanded.data(), static_cast<std::streamsize>(expanded.size()));
+}
+
+void TabStreambuf::drain() {
+    auto const size = static_cast<std::size_t>(pptr() - pbase());
+    write(std::string_view(pbase(), size));
+    setp(buffer.data(), buffer.data() + buffer.size());
+}
+
+TabStream::TabStream(std::ostream& dest, TabOptions options):
+    std::ostream(&buf), buf(dest, options) {
+    copyFormatFlags(dest, *this);
+}
@@ -1,28 +1,20 @@
 #include "termfmt/termfmt.h"
 
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <charconv>
+#include <cstdint>
+#include <functional>
 #include <iostream>
 #include <new>
+#include <span>
+#include <variant>
 #include <vector>
 
-#if !defined(_WIN32) && (defined(__unix__) || defined(__unix) ||               \
-                         (defined(__APPLE__) && defined(__MACH__)))
-#define TFMT_UNIX 1
-#elif defined(_WIN32)
-#define TFMT_WINDOWS 1
-#else
-#error Unknown platform
-#endif
-
-#if TFMT_UNIX
-#include <stdio.h>
-#include <sys/ioctl.h>
-#include <unistd.h>
-#elif TFMT_WINDOWS
-// #   define NOMINMAX
-#include <io.h>
-#include <windows.h>
-#endif
+#include "platform.h"
+#include "termfmt/ansi.h"
+#include "termfmt/grapheme.h"
 
 using namespace tfmt;
 
@@ -88,6 +80,7 @@ static long iword(std::ios_base const& ios) {
 
 static constexpr size_t terminalBit = 0;
 static constexpr size_t htmlBit = 1;
+static constexpr size_t svgBit = 2;
 static constexpr size_t widthMask = 0xFF00;
 
 static size_t getWidthImpl() {
@@ -134,7 +127,9 @@ template void tfmt::setWidth(std::wostream&, size_t);
 template <typename CharT, typename Traits>
 void tfmt::setTermFormattable(std::basic_ostream<CharT, Traits>& ostream,
                               bool value) {
-    iword(ostream) |= static_cast<size_t>(value) << terminalBit;
+    auto& word = iword(ostream);
+    word &= ~(1l << terminalBit);
+    word |= static_cast<long>(value) << terminalBit;
 }
 
 template void tfmt::setTermFormattable(std::ostream&, bool);
@@ -151,7 +146,9 @@ template bool tfmt::isTermFormattable(std::wostream const&);
 template <typename CharT, typename Traits>
 void tfmt::setHTMLFormattable(std::basic_ostream<CharT, Traits>& ostream,
                               bool value) {
-    iword(ostream) |= value << htmlBit;
+    auto& word = iword(ostream);
+    word &= ~(1l << htmlBit);
+    word |= static_cast<long>(value) << htmlBit;
 }
 
 template void tfmt::setHTMLFormattable(std::ostream&, bool);
@@ -165,6 +162,25 @@ bool tfmt::isHTMLFormattable(std::basic_ostream<CharT, Traits> const& ostream) {
 template bool tfmt::isHTMLFormattable(std::ostream const&);
 template bool tfmt::isHTMLFormattable(std::wostream const&);
 
+template <typename CharT, typename Traits>
+void tfmt::setSVGFormattable(std::basic_ostream<CharT, Traits>& ostream,
+                             bool value) {
+    auto& word = iword(ostream);
+    word &= ~(1l << svgBit);
+    word |= static_cast<long>(value) << svgBit;
+}
+
+template void tfmt::setSVGFormattable(std::ostream&, bool);
+template void tfmt::setSVGFormattable(std::wostream&, bool);
+
+template <typename CharT, typename Traits>
+bool tfmt::isSVGFormattable(std::basic_ostream<CharT, Traits> const& ostream) {
+    return !!(iword(ostream) & 1 << svgBit);
+}
+
+template bool tfmt::isSVGFormattable(std::ostream const&);
+template bool tfmt::isSVGFormattable(std::wostream const&);
+
 template <typename CharT, typename Traits>
 void tfmt::copyFormatFlags(std::basic_ostream<CharT, Traits> const& source,
                            std::basic_ostream<CharT, Traits>& dest) {
@@ -174,11 +190,130 @@ void tfmt::copyFormatFlags(std::basic_ostream<CharT, Traits> const& source,
     if (isHTMLFormattable(source)) {
         setHTMLFormattable(dest);
     }
+    if (isSVGFormattable(source)) {
+        setSVGFormattable(dest);
+    }
 }
 
 template void tfmt::copyFormatFlags(std::ostream const&, std::ostream&);
 template void tfmt::copyFormatFlags(std::wostream const&, std::wostream&);
 
+/// \Returns the display width of \p text, measured by grapheme clusters
+static size_t measureWidth(std::string_view text) {
+    size_t width = 0;
+    parseAnsi(text, [&](AnsiEvent const& event) {
+        if (event.kind == AnsiEventKind::Text) {
+            forEachGrapheme(event.text, [&](std::string_view, size_t w) {
+                width += w;
+            });
+        }
+    });
+    return width;
+}
+
+namespace {
+
+/// Set associative cache of the widths of recently measured strings
+/// \details Every string hashes to one set of `Ways` entries, and a miss
+/// replaces the least recently used entry of the set. Only strings up to
+/// `MaxKeySize` bytes are cached, so the memory usage is bounded.
+class WidthCache {
+public:
+    static WidthCache& local() {
+        thread_local WidthCache cache;
+        return cache;
+    }
+
+    static constexpr size_t MaxKeySize = 128;
+
+    size_t width(std::string_view text) {
+        size_t const hash = std::hash<std::string_view>{}(text);
+        Entry* const set = &entries[(hash % NumSets) * Ways];
+        Entry* victim = set;
+        for (size_t i = 0; i < Ways; ++i) {
+            Entry& entry = set[i];
+            if (entry.hash == hash && entry.key == text) {
+                entry.lastUse = ++clock;
+                return entry.width;
+            }
+            if (entry.lastUse < victim->lastUse) {
+                victim = &entry;
+            }
+        }
+        victim->hash = hash;
+        victim->key.assign(text);
+        victim->width = measureWidth(text);
+        victim->lastUse = ++clock;
+        return victim->width;
+    }
+
+private:
+    static constexpr size_t NumSets = 64;
+    static constexpr size_t Ways = 8;
+
+    struct Entry {
+        size_t hash = 0;
+        std::uint64_t lastUse = 0;
+        std::string key;
+        size_t width = 0;
+    };
+
+    std::array<Entry, NumSets * Ways> entries;
+    std::uint64_t clock = 0;
+};
+
+} // namespace
+
+size_t tfmt::displayWidth(std::string_view text) {
+    unsigned char bits = 0;
+    bool controls = false;
+    for (char const c: text) {
+        auto const uc = static_cast<unsigned char>(c);
+        bits |= uc;
+        controls |= uc < 0x20 || uc == 0x7F;
+    }
+    // ASCII text is cheaper to measure than to look up. Every character
+    // outside of escape sequences but control characters is one column wide.
+    if ((bits & 0x80) == 0) {
+        if (!controls) {
+            return text.size();
+        }
+        size_t width = 0;
+        parseAnsi(text, [&](AnsiEvent const& event) {
+            if (event.kind == AnsiEventKind::Text) {
+                width += event.text.size();
+            }
+        });
+        return width;
+    }
+    if (text.size() > WidthCache::MaxKeySize) {
+        return measureWidth(text);
+    }
+    return WidthCache::local().width(text);
+}
+
+std::string_view tfmt::truncateToWidth(std::string_view text, size_t width) {
+    AnsiParser parser;
+    parser.feed(text);
+    size_t columns = 0;
+    while (auto event = parser.next()) {
+        if (event->kind != AnsiEventKind::Text) {
+            continue;
+        }
+        auto const run = event->text;
+        size_t i = 0;
+        while (i < run.size()) {
+            Grapheme const grapheme = nextGrapheme(run.substr(i));
+            if (columns + grapheme.width > width) {
+                return text.substr(0, size_t(run.data() - text.data()) + i);
+            }
+            columns += grapheme.width;
+            i += grapheme.size;
+        }
+    }
+    return text;
+}
+
 template <typename CharT, typename Traits>
 static void putString(std::basic_ostream<CharT, Traits>& ostream,
                       std::string_view str) {
@@ -187,19 +322,261 @@ static void putString(std::basic_ostream<CharT, Traits>& ostream,
     }
 }
 
+/// \Returns `true` if the single SGR code \p p sets or clears an attribute
+/// that `Attributes` tracks
+static bool isTrackedCode(unsigned p) {
+    return p <= 5 || (p >= 7 && p <= 9) || (p >= 22 && p <= 25) ||
+           (p >= 27 && p <= 37) || p == 39 || (p >= 40 && p <= 47) ||
+           p == 49 || (p >= 90 && p <= 97) || (p >= 100 && p <= 107);
+}
+
+bool internal::applySGR(Attributes& attribs,
+                        std::span<unsigned const> params,
+                        std::uint32_t subparams) {
+    if (params.empty()) {
+        attribs = Attributes::makeReset();
+        return false;
+    }
+    bool untracked = false;
+    auto isSubparam = [&](size_t i) { return (subparams >> i & 1) != 0; };
+    auto makeRGB = [](std::span<unsigned const> rgb) {
+        return Attributes::makeColor(Attributes::RGBColor,
+                                     (rgb[0] & 0xFF) << 16 |
+                                         (rgb[1] & 0xFF) << 8 |
+                                         (rgb[2] & 0xFF));
+    };
+    for (size_t i = 0; i < params.size();) {
+        unsigned const p = params[i];
+        size_t end = i + 1;
+        while (end < params.size() && isSubparam(end)) {
+            ++end;
+        }
+        auto const group = params.subspan(i, end - i);
+        i = end;
+        if (group.size() > 1) {
+            // Colon separated subparameters: 38:5:n, 38:2::r:g:b and
+            // 38:2:r:g:b with an optional color space, the same for 48, and
+            // underline styles like 4:3. Unknown groups are skipped whole.
+            if ((p == 38 || p == 48) && group.size() == 3 && group[1] == 5) {
+                (p == 38 ? attribs.fg : attribs.bg) =
+                    Attributes::makeColor(Attributes::IndexedColor,
+                                          group[2] & 0xFF);
+            }
+            else if ((p == 38 || p == 48) &&
+                     (group.size() == 5 || group.size() == 6) && group[1] == 2)
+            {
+                (p == 38 ? attribs.fg : attribs.bg) = makeRGB(group.last(3));
+            }
+            else if (p == 4 && group.size() == 2 && group[1] <= 1) {
+                attribs.flags = group[1] == 0 ?
+                                    attribs.flags & ~Attributes::Underline :
+                                    attribs.flags | Attributes::Underline;
+            }
+            else {
+                // Curly, dotted and dashed underlines are tracked as plain
+                // ones
+                if (p == 4) {
+                    attribs.flags |= Attributes::Underline;
+                }
+                untracked = true;
+            }
+            continue;
+        }
+        // Extended colors: 38;5;n, 38;2;r;g;b and the same for 48 and the
+        // untracked underline color 58
+        if (p == 38 || p == 48 || p == 58) {
+            unsigned const kind = i < params.size() ? params[i] : 0;
+            size_t const size = kind == 2 ? 4 : 2;
+            if (p == 58 || (kind != 2 && kind != 5) ||
+                i + size > params.size())
+            {
+                // The rest of an incomplete color can't be interpreted
+                untracked = true;
+                i = kind == 2 || kind == 5 ?
+                        std::min(i + size, params.size()) :
+                        params.size();
+                continue;
+            }
+            auto& color = p == 38 ? attribs.fg : attribs.bg;
+            color = size == 2 ? Attributes::makeColor(Attributes::IndexedColor,
+                                                      params[i + 1] & 0xFF) :
+                                makeRGB(params.subspan(i + 1, 3));
+            i += size;
+            continue;
+        }
+        if (!isTrackedCode(p)) {
+            untracked = true;
+            continue;
+        }
+        switch (p) {
+        case 0:
+            attribs = Attributes::makeReset();
+            untracked = false;
+            break;
+        case 1: attribs.flags |= Attributes::Bold; break;
+        case 2: attribs.flags |= Attributes::Dim; break;
+        case 3: attribs.flags |= Attributes::Italic; break;
+        case 4: attribs.flags |= Attributes::Underline; break;
+        case 5: attribs.flags |= Attributes::Blink; break;
+        case 7: attribs.flags |= Attributes::Inverse; break;
+        case 8: attribs.flags |= Attributes::Concealed; break;
+        case 9: attribs.flags |= Attributes::Crossed; break;
+        case 22: attribs.flags &= ~(Attributes::Bold | Attributes::Dim); break;
+        case 23: attribs.flags &= ~Attributes::Italic; break;
+        case 24: attribs.flags &= ~Attributes::Underline; break;
+        case 25: attribs.flags &= ~Attributes::Blink; break;
+        case 27: attribs.flags &= ~Attributes::Inverse; break;
+        case 28: attribs.flags &= ~Attributes::Concealed; break;
+        case 29: attribs.flags &= ~Attributes::Crossed; break;
+        case 39: attribs.fg = Attributes::DefaultColor; break;
+        case 49: attribs.bg = Attributes::DefaultColor; break;
+        default:
+            if ((p >= 30 && p <= 37) || (p >= 90 && p <= 97)) {
+                attribs.fg = Attributes::makeColor(Attributes::BasicColor, p);
+            }
+            else {
+                attribs.bg = Attributes::makeColor(Attributes::BasicColor, p);
+            }
+            break;
+        }
+    }
+    return untracked;
+}
+
+internal::Attributes internal::parseAttributes(std::string_view ansi,
+                                               Attributes base) {
+    Attributes attribs = base;
+    parseAnsi(ansi, [&](AnsiEvent const& event) {
+        if (event.kind == AnsiEventKind::Style) {
+            applySGR(attribs, event.params, event.subparams);
+        }
+    });
+    return attribs;
+}
+
+bool internal::setsUntracked(std::string_view ansi) {
+    bool untracked = false;
+    parseAnsi(ansi, [&](AnsiEvent const& event) {
+        if (event.kind != AnsiEventKind::Style) {
+            return;
+        }
+        Attributes attribs;
+        bool const sets = applySGR(attribs, event.params, event.subparams);
+        // Only a reset undoes the untracked attributes set before it
+        untracked = sets || (untracked && !attribs.reset);
+    });
+    return untracked;
+}
+
+static void appendNumber(std::string& out, std::uint32_t value) {
+    char buffer[16];
+    char* end = std::to_chars(std::begin(buffer), std::end(buffer), value).ptr;
+    out.append(buffer, end);
+}
+
+static void appendColor(std::string& out, std::uint32_t color, bool fg) {
+    using internal::Attributes;
+    std::uint32_t const value = color & 0xFFFFFF;
+    switch (Attributes::colorKind(color)) {
+    case Attributes::DefaultColor:
+        appendNumber(out, fg ? 39 : 49);
+        break;
+    case Attributes::BasicColor:
+        appendNumber(out, value);
+        break;
+    case Attributes::IndexedColor:
+        out += fg ? "38;5;" : "48;5;";
+        appendNumber(out, value);
+        break;
+    case Attributes::RGBColor:
+        out += fg ? "38;2;" : "48;2;";
+        appendNumber(out, value >> 16);
+        out += ';';
+        appendNumber(out, value >> 8 & 0xFF);
+        out += ';';
+        appendNumber(out, value & 0xFF);
+        break;
+    }
+}
+
+void internal::appendTransition(Attributes const& from,
+                                Attributes const& to,
+                                std::string& out) {
+    size_t const start = out.size();
+    auto separate = [&] { out += out.size() == start ? "\033[" : ";"; };
+    auto putCode = [&](std::string_view code) {
+        separate();
+        out += code;
+    };
+    std::uint16_t const removed = from.flags & ~to.flags;
+    std::uint16_t added = to.flags & ~from.flags;
+    // Off codes come first, because 22 undoes both bold and dim and we may
+    // have to enable one of them again
+    if (removed & (Attributes::Bold | Attributes::Dim)) {
+        putCode("22");
+        added |= to.flags & (Attributes::Bold | Attributes::Dim);
+    }
+    using FlagCode = std::pair<Attributes::Flag, std::string_view>;
+    static constexpr FlagCode OffCodes[] = {
+        { Attributes::Italic, "23" },    { Attributes::Underline, "24" },
+        { Attributes::Blink, "25" },     { Attributes::Inverse, "27" },
+        { Attributes::Concealed, "28" }, { Attributes::Crossed, "29" },
+    };
+    for (auto [flag, code]: OffCodes) {
+        if (removed & flag) {
+            putCode(code);
+        }
+    }
+    if (from.fg != to.fg) {
+        separate();
+        appendColor(out, to.fg, /* fg = */ true);
+    }
+    if (from.bg != to.bg) {
+        separate();
+        appendColor(out, to.bg, /* fg = */ false);
+    }
+    static constexpr FlagCode OnCodes[] = {
+        { Attributes::Bold, "1" },      { Attributes::Dim, "2" },
+        { Attributes::Italic, "3" },    { Attributes::Underline, "4" },
+        { Attributes::Blink, "5" },     { Attributes::Inverse, "7" },
+        { Attributes::Concealed, "8" }, { Attributes::Crossed, "9" },
+    };
+    for (auto [flag, code]: OnCodes) {
+        if (added & flag) {
+            putCode(code);
+        }
+    }
+    if (out.size() != start) {
+        out += 'm';
+    }
+}
+
+/// \Returns `true` if ANSI format codes shall be written to \p ostream
+template <typename CharT, typename Traits>
+static bool wantsANSI(std::basic_ostream<CharT, Traits> const& ostream) {
+    // SVG stream buffers translate ANSI format codes themselves
+    return isTermFormattable(ostream) || isSVGFormattable(ostream);
+}
+
+template <typename CharT, typename Traits>
+static void putHTML(std::basic_ostream<CharT, Traits>& ostream,
+                    internal::ModBase const& mod) {
+    if (mod.isResetModifier()) {
+        ostream << "</font>";
+        return;
+    }
+    ostream << "<font color=\"";
+    putString(ostream, mod.htmlBuffer().front());
+    ostream << "\">";
+}
+
 template <typename CharT, typename Traits>
 void internal::ModBase::put(std::basic_ostream<CharT, Traits>& ostream) const {
-    if (isTermFormattable(ostream)) {
+    if (wantsANSI(ostream)) {
         putString(ostream, ansiBuf);
     }
     if (isHTMLFormattable(ostream)) {
-        if (isReset) {
-            ostream << "</font>";
-            return;
-        }
-        ostream << "<font color=\"";
-        putString(ostream, htmlBuf.front());
-        ostream << "\">";
+        putHTML(ostream, *this);
     }
 }
 
@@ -208,37 +585,163 @@ template void internal::ModBase::put(std::wostream&) const;
 
 namespace {
 
+/// Stack of modifiers pushed to a stream
+/// \details Along with every modifier we store the attributes in effect
+/// while it is on top of the stack. Pushing and popping then only emits the
+/// codes for the attributes that actually change, so the cost does not
+/// depend on the depth of the stack. Modifiers pushed with
+/// `pushModifierRef()` are referenced instead of copied.
 class ModStack {
 public:
     ModStack() noexcept = default;
 
-    void push(Modifier&& mod) { mods.push_back(std::move(mod)); }
+    template <typename CharT, typename Traits>
+    void push(Modifier&& mod, std::basic_ostream<CharT, Traits>& ostream) {
+        pushEntry(std::move(mod), ostream);
+    }
 
-    void pop() { mods.pop_back(); }
+    template <typename CharT, typename Traits>
+    void push(Modifier const* mod, std::basic_ostream<CharT, Traits>& ostream) {
+        pushEntry(mod, ostream);
+    }
 
     template <typename CharT, typename Traits>
-    void apply(std::basic_ostream<CharT, Traits>& ostream) const {
-        for (Modifier mod: mods) {
-            ostream << mod;
+    void pop(std::basic_ostream<CharT, Traits>& ostream) {
+        auto popped = std::move(entries.back());
+        entries.pop_back();
+        if (wantsANSI(ostream)) {
+            if (entries.empty()) {
+                // The attributes of the only entry are the ones of its
+                // modifier, so we can use its pre-rendered off codes
+                putString(ostream, popped.modifier().ansiOffBuffer());
+            }
+            else if (popped.modifier().hasUntrackedCodes() ||
+                     (entries.back().untracked &&
+                      popped.modifier().attributes().reset))
+            {
+                // Transitions can't undo or restore untracked attributes
+                putAll(ostream);
+            }
+            else {
+                putTransition(ostream, popped.state, top());
+            }
+        }
+        if (isHTMLFormattable(ostream)) {
+            ostream << "</font>";
         }
     }
 
+    /// Reapplies all modifiers after the stream has been reset
     template <typename CharT, typename Traits>
-    void reset(std::basic_ostream<CharT, Traits>& ostream) const {
-        for (Modifier mod: mods) {
-            ostream << tfmt::Reset;
+    void reapply(std::basic_ostream<CharT, Traits>& ostream) const {
+        if (entries.empty()) {
+            return;
+        }
+        if (wantsANSI(ostream)) {
+            if (entries.back().untracked) {
+                putAll(ostream);
+            }
+            else {
+                putString(ostream, tfmt::Reset.ansiBuffer());
+                putTransition(ostream, {}, top());
+            }
+        }
+        if (isHTMLFormattable(ostream)) {
+            for (size_t i = 0; i < entries.size(); ++i) {
+                ostream << "</font>";
+            }
+            for (auto& entry: entries) {
+                putHTML(ostream, entry.modifier());
+            }
         }
     }
 
+    /// Removes all entries without undoing their modifiers
+    void clear() { entries.clear(); }
+
+    /// \Returns the attributes currently in effect
+    internal::Attributes top() const {
+        return entries.empty() ? internal::Attributes{} : entries.back().state;
+    }
+
 private:
-    std::vector<Modifier> mods;
+    struct Entry {
+        Modifier const& modifier() const {
+            if (auto* borrowed = std::get_if<Modifier const*>(&mod)) {
+                return **borrowed;
+            }
+            return std::get<Modifier>(mod);
+        }
+
+        std::variant<Modifier, Modifier const*> mod;
+        internal::Attributes state;
+        /// `true` if attributes that `state` doesn't track are in effect
+        bool untracked = false;
+    };
+
+    template <typename M, typename CharT, typename Traits>
+    void pushEntry(M&& mod, std::basic_ostream<CharT, Traits>& ostream) {
+        auto const previous = top();
+        bool const previousUntracked =
+            !entries.empty() && entries.back().untracked;
+        auto& entry = entries.emplace_back(Entry{ std::forward<M>(mod), {} });
+        auto const& modifier = entry.modifier();
+        auto const& attribs = modifier.attributes();
+        entry.state = internal::combine(previous, attribs);
+        entry.untracked = modifier.hasUntrackedCodes() ||
+                          (previousUntracked && !attribs.reset);
+        if (wantsANSI(ostream)) {
+            if (entries.size() == 1) {
+                // Nothing is applied yet, so the pre-rendered codes of the
+                // modifier are the transition
+                putString(ostream, modifier.ansiBuffer());
+            }
+            else if (modifier.hasUntrackedCodes() ||
+                     (previousUntracked && attribs.reset))
+            {
+                // Transitions neither set nor reset untracked attributes, so
+                // the codes of the modifier are written as they are
+                putString(ostream, modifier.ansiBuffer());
+                putTransition(
+                    ostream,
+                    internal::parseAttributes(modifier.ansiBuffer(), previous),
+                    entry.state);
+            }
+            else {
+                putTransition(ostream, previous, entry.state);
+            }
+        }
+        if (isHTMLFormattable(ostream)) {
+            putHTML(ostream, modifier);
+        }
+    }
+
+    /// Writes a reset and the codes of all modifiers, which restores the
+    /// attributes that transitions don't track as well
+    template <typename CharT, typename Traits>
+    void putAll(std::basic_ostream<CharT, Traits>& ostream) const {
+        putString(ostream, tfmt::Reset.ansiBuffer());
+        for (auto const& entry: entries) {
+            putString(ostream, entry.modifier().ansiBuffer());
+        }
+    }
+
+    template <typename CharT, typename Traits>
+    static void putTransition(std::basic_ostream<CharT, Traits>& ostream,
+                              internal::Attributes const& from,
+                              internal::Attributes const& to) {
+        std::string codes;
+        internal::appendTransition(from, to, codes);
+        putString(ostream, codes);
+    }
+
+    std::vector<Entry> entries;
 };
 
 } // namespace
 
 template <typename CharT, typename Traits>
-void tfmt::pushModifier(Modifier mod,
-                        std::basic_ostream<CharT, Traits>& ostream) {
+static ModStack& getModStack(std::basic_ostream<CharT, Traits>& ostream) {
     int index = tcOStreamIndex();
     auto* stackPtr = static_cast<ModStack*>(ostream.pword(index));
     if (stackPtr == nullptr) {
@@ -255,10 +758,19 @@ void tfmt::pushModifier(Modifier mod,
         },
             index);
     }
-    auto& stack = *stackPtr;
-    stack.reset(ostream);
-    stack.push(std::move(mod));
-    stack.apply(ostream);
+    return *stackPtr;
+}
+
+template <typename CharT, typename Traits>
+void tfmt::pushModifier(Modifier mod,
+                        std::basic_ostream<CharT, Traits>& ostream) {
+    getModStack(ostream).push(std::move(mod), ostream);
+}
+
+template <typename CharT, typename Traits>
+void tfmt::pushModifierRef(Modifier const& mod,
+                           std::basic_ostream<CharT, Traits>& ostream) {
+    getModStack(ostream).push(&mod, ostream);
 }
 
 template <typename CharT, typename Traits>
@@ -267,10 +779,7 @@ void tfmt::popModifier(std::basic_ostream<CharT, Traits>& ostream) {
     auto* const stackPtr = static_cast<ModStack*>(ostream.pword(index));
     assert(stackPtr && "popModifier called without a matching prior call to "
                        "pushModifier()");
-    auto& stack = *stackPtr;
-    stack.reset(ostream);
-    stack.pop();
-    stack.apply(ostream);
+    stackPtr->pop(ostream);
 }
 
 template <typename CharT, typename Traits>
@@ -278,20 +787,48 @@ void tfmt::reapplyModifiers(std::basic_ostream<CharT, Traits>& ostream) {
     int index = tcOStreamIndex();
     auto* const stackPtr = static_cast<ModStack*>(ostream.pword(index));
     if (stackPtr) {
-        stackPtr->reset(ostream);
-        stackPtr->apply(ostream);
+        stackPtr->reapply(ostream);
+    }
+}
+
+template <typename CharT, typename Traits>
+internal::Attributes internal::currentAttributes(
+    std::basic_ostream<CharT, Traits> const& ostream) {
+    // See `iword()` for why we cast away constness
+    auto& mutOstream = const_cast<std::basic_ostream<CharT, Traits>&>(ostream);
+    auto const* const stackPtr =
+        static_cast<ModStack const*>(mutOstream.pword(tcOStreamIndex()));
+    return stackPtr ? stackPtr->top() : Attributes{};
+}
+
+template <typename CharT, typename Traits>
+void internal::clearModifiers(std::basic_ostream<CharT, Traits>& ostream) {
+    auto* const stackPtr =
+        static_cast<ModStack*>(ostream.pword(tcOStreamIndex()));
+    if (stackPtr) {
+        stackPtr->clear();
     }
 }
 
 template void tfmt::pushModifier(Modifier, std::ostream&);
 template void tfmt::pushModifier(Modifier, std::wostream&);
 
+template void tfmt::pushModifierRef(Modifier const&, std::ostream&);
+template void tfmt::pushModifierRef(Modifier const&, std::wostream&);
+
 template void tfmt::popModifier(std::ostream&);
 template void tfmt::popModifier(std::wostream&);
 
 template void tfmt::reapplyModifiers(std::ostream&);
 template void tfmt::reapplyModifiers(std::wostream&);
 
+template internal::Attributes internal::currentAttributes(std::ostream const&);
+template internal::Attributes internal::currentAttributes(
+    std::wostream const&);
+
+template void internal::clearModifiers(std::ostream&);
+template void internal::clearModifiers(std::wostream&);
+
 void tfmt::pushModifier(Modifier mod) {
     pushModifier(std::move(mod), std::cout);
 }
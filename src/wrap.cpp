@@ -0,0 +1,223 @@
+#include "termfmt/wrap.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <vector>
+
+#include "termfmt/termfmt.h"
+
+using namespace tfmt;
+using internal::Attributes;
+
+namespace {
+
+/// A word of a paragraph. Escape sequences that are separated from the
+/// surrounding words by spaces are kept as additional pieces of the word
+/// before them, so they never start a line of their own.
+struct Word {
+    /// Range of the pieces of the word
+    std::size_t begin, end;
+
+    /// Display width of all pieces
+    std::size_t width;
+};
+
+/// Line breaking state that is reused for all paragraphs
+struct Wrapper {
+    WrapOptions const& options;
+    std::size_t available;
+    std::string& out;
+    std::vector<std::string_view> pieces = {};
+    std::vector<Word> words = {};
+    /// Index of the first word of every line followed by the total number of
+    /// words
+    std::vector<std::size_t> breaks = {};
+    std::vector<std::uint64_t> cost = {};
+    std::vector<std::size_t> from = {};
+    Attributes current = {};
+
+    void paragraph(std::string_view line);
+    void split(std::string_view line);
+    void breakGreedy();
+    void breakOptimal();
+    void emit();
+    void put(std::string_view piece);
+    void endLine();
+};
+
+} // namespace
+
+void Wrapper::paragraph(std::string_view line) {
+    split(line);
+    if (words.empty()) {
+        // Keep escape sequences of lines without words
+        for (auto piece: pieces) {
+            put(piece);
+        }
+        return;
+    }
+    if (options.mode == WrapMode::Optimal) {
+        breakOptimal();
+    }
+    else {
+        breakGreedy();
+    }
+    emit();
+}
+
+void Wrapper::split(std::string_view line) {
+    pieces.clear();
+    words.clear();
+    std::size_t i = 0;
+    while (true) {
+        while (i < line.size() && (line[i] == ' ' || line[i] == '\t')) {
+            ++i;
+        }
+        if (i == line.size()) {
+            break;
+        }
+        std::size_t const end =
+            std::min(line.find_first_of(" \t", i), line.size());
+        auto const piece = line.substr(i, end - i);
+        i = end;
+        std::size_t const width = displayWidth(piece);
+        pieces.push_back(piece);
+        if (width == 0 && !words.empty()) {
+            words.back().end = pieces.size();
+            continue;
+        }
+        // Escape sequences before the first word belong to the first word
+        if (width > 0) {
+            std::size_t const begin = words.empty() ? 0 : pieces.size() - 1;
+            words.push_back({ begin, pieces.size(), width });
+        }
+    }
+}
+
+void Wrapper::breakGreedy() {
+    breaks.clear();
+    std::size_t lineWidth = 0;
+    for (std::size_t i = 0; i < words.size(); ++i) {
+        if (i > 0 && lineWidth + 1 + words[i].width <= available) {
+            lineWidth += 1 + words[i].width;
+            continue;
+        }
+        breaks.push_back(i);
+        lineWidth = words[i].width;
+    }
+    breaks.push_back(words.size());
+}
+
+void Wrapper::breakOptimal() {
+    // cost[j] is the minimal cost of breaking the first j words, from[j] is
+    // the first word of the last line of that solution. Lines that would be
+    // wider than the available width are never considered, so the inner
+    // loop runs at most over the words that fit on one line.
+    std::size_t const count = words.size();
+    cost.assign(count + 1, std::numeric_limits<std::uint64_t>::max());
+    from.assign(count + 1, 0);
+    cost[0] = 0;
+    for (std::size_t j = 1; j <= count; ++j) {
+        std::size_t lineWidth = words[j - 1].width;
+        for (std::size_t i = j; i-- > 0;) {
+            if (i + 1 < j) {
+                lineWidth += 1 + words[i].width;
+                if (lineWidth > available) {
+                    break;
+                }
+            }
+            std::uint64_t lineCost = 0;
+            // The last line and words wider than a line are free
+            if (j < count && lineWidth < available) {
+                auto const slack = std::uint64_t(available - lineWidth);
+                lineCost = slack * slack;
+            }
+            if (cost[i] + lineCost < cost[j]) {
+                cost[j] = cost[i] + lineCost;
+                from[j] = i;
+            }
+        }
+    }
+    breaks.clear();
+    for (std::size_t j = count; j > 0; j = from[j]) {
+        breaks.push_back(from[j]);
+    }
+    std::reverse(breaks.begin(), breaks.end());
+    breaks.push_back(count);
+}
+
+void Wrapper::emit() {
+    for (std::size_t l = 0; l + 1 < breaks.size(); ++l) {
+        std::size_t const begin = breaks[l];
+        std::size_t const end = breaks[l + 1];
+        if (l > 0) {
+            endLine();
+        }
+        out.append(options.indent, ' ');
+        internal::appendTransition({}, current, out);
+        std::size_t lineWidth = end - begin - 1;
+        for (std::size_t i = begin; i < end; ++i) {
+            lineWidth += words[i].width;
+        }
+        std::size_t const gaps = end - begin - 1;
+        bool const justify = options.justify && end < words.size() &&
+                             gaps > 0 && lineWidth < available;
+        std::size_t const extra = justify ? available - lineWidth : 0;
+        for (std::size_t i = begin; i < end; ++i) {
+            if (i > begin) {
+                std::size_t const gap = i - begin - 1;
+                std::size_t spaces = 1;
+                if (justify) {
+                    spaces += extra / gaps + (gap < extra % gaps);
+                }
+                out.append(spaces, ' ');
+            }
+            for (std::size_t p = words[i].begin; p < words[i].end; ++p) {
+                put(pieces[p]);
+            }
+        }
+    }
+}
+
+void Wrapper::put(std::string_view piece) {
+    out += piece;
+    if (piece.find('\033') != std::string_view::npos) {
+        current = internal::parseAttributes(piece, current);
+        current.reset = false;
+    }
+}
+
+void Wrapper::endLine() {
+    internal::appendTransition(current, {}, out);
+    out += '\n';
+}
+
+std::string tfmt::wrap(std::string_view text, WrapOptions const& options) {
+    std::string out;
+    out.reserve(text.size() + text.size() / 8);
+    std::size_t const width = options.width.value_or(80);
+    std::size_t const available =
+        width > options.indent ? width - options.indent : 1;
+    Wrapper wrapper{ options, available, out };
+    while (true) {
+        std::size_t const end = text.find('\n');
+        wrapper.paragraph(text.substr(0, end));
+        if (end == std::string_view::npos) {
+            break;
+        }
+        wrapper.endLine();
+        text.remove_prefix(end + 1);
+    }
+    return out;
+}
+
+void tfmt::wrap(std::ostream& ostream,
+                std::string_view text,
+                WrapOptions const& options) {
+    WrapOptions streamOptions = options;
+    streamOptions.width =
+        options.width.value_or(getWidth(ostream).value_or(80));
+    ostream << wrap(text, streamOptions);
+}
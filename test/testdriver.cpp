@@ -1,10 +1,41 @@
+#include <algorithm>
 #include <cassert>
+#include <charconv>
+#include <cmath>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
 #include <iomanip>
 #include <iostream>
+#include <locale>
 #include <sstream>
 #include <string_view>
+#include <thread>
+#include <vector>
 
+#include "termfmt/animation.h"
+#include "termfmt/ansi.h"
+#include "termfmt/backtrace.h"
+#include "termfmt/builder.h"
+#include "termfmt/flamegraph.h"
+#include "termfmt/grapheme.h"
+#include "termfmt/histogram.h"
+#include "termfmt/join.h"
+#include "termfmt/live.h"
+#include "termfmt/log.h"
+#include "termfmt/number.h"
+#include "termfmt/optimize.h"
+#include "termfmt/prerendered.h"
+#include "termfmt/sanitize.h"
+#include "termfmt/shared_output.h"
+#include "termfmt/sixel.h"
+#include "termfmt/string_stream.h"
+#include "termfmt/svg.h"
+#include "termfmt/table.h"
+#include "termfmt/tabs.h"
 #include "termfmt/termfmt.h"
+#include "termfmt/wrap.h"
 
 static void separator(int width) {
     for (int i = 0; i < width; ++i) {
@@ -79,10 +110,1109 @@ static void testFormatCallback() {
     });
 }
 
+static void testDisplayWidth() {
+    assert(tfmt::displayWidth("abc") == 3);
+    assert(tfmt::displayWidth("\033[31mabc\033[00m") == 3);
+    assert(tfmt::displayWidth("\033]8;;url\033\\link\033]8;;\033\\") == 4);
+    assert(tfmt::displayWidth("\xc3\xa4\xc3\xb6") == 2);
+    // Combining marks, wide characters, flags and emoji sequences
+    for (int i = 0; i < 2; ++i) {
+        assert(tfmt::displayWidth("e\u0301") == 1);
+        assert(tfmt::displayWidth("\u65e5\u672c") == 4);
+        assert(tfmt::displayWidth("\U0001F1E9\U0001F1EA") == 2);
+        assert(tfmt::displayWidth("\U0001F468\u200D\U0001F469\u200D"
+                                  "\U0001F467") == 2);
+        assert(tfmt::displayWidth("\u2764\uFE0F") == 2);
+        assert(tfmt::displayWidth("\u1100\u1161\u11A8") == 2);
+    }
+    auto const family = "\U0001F468\u200D\U0001F469";
+    assert(tfmt::nextGrapheme(family).size == std::strlen(family));
+    assert(tfmt::nextGrapheme("\r\nx").size == 2);
+    assert(tfmt::nextGrapheme("\xff\xfe").size == 1);
+    // Clusters are never split
+    assert(tfmt::truncateToWidth("ae\u0301b", 2) == "ae\u0301");
+    assert(tfmt::truncateToWidth("a\u65e5", 2) == "a");
+}
+
+static void testBacktrace() {
+    header(" Backtrace ");
+    auto backtrace = tfmt::Backtrace::capture();
+    assert(!backtrace.empty());
+    // Frames are cached, so repeated lookups yield the same strings
+    auto first = backtrace.frame(0);
+    auto second = backtrace.frame(0);
+    assert(first.function.data() == second.function.data());
+    assert(first.module.data() == second.module.data());
+    // Printed offsets are relative to the module, which contains the function
+    for (std::size_t i = 0; i < backtrace.size(); ++i) {
+        auto const frame = backtrace.frame(i);
+        if (!frame.module.empty() && !frame.function.empty()) {
+            assert(frame.moduleOffset >= frame.offset);
+        }
+    }
+    std::cout << backtrace;
+}
+
+static void testLogLevels() {
+    header(" Log levels ");
+    int evaluated = 0;
+    auto arg = [&] {
+        ++evaluated;
+        return "argument";
+    };
+    std::stringstream sstr;
+    tfmt::setLogLevel(tfmt::LogLevel::Warning);
+    TFMT_LOG_INFO(sstr, "dropped ", arg());
+    assert(evaluated == 0);
+    assert(sstr.str().empty());
+    TFMT_LOG_ERROR(sstr, "kept ", arg());
+    assert(evaluated == 1);
+    assert(sstr.str() == "ERROR kept argument\n");
+    assert(tfmt::logLevelName(tfmt::LogLevel::Info) == "INFO");
+    tfmt::setLogLevel(tfmt::LogLevel::Trace);
+    tfmt::setLogPrefixFlags(tfmt::LogPrefixFlags::All);
+    TFMT_LOG_TRACE(std::cout, "This is a trace message");
+    TFMT_LOG_DEBUG(std::cout, "This is a debug message");
+    TFMT_LOG_INFO(std::cout, "This is an info message");
+    TFMT_LOG_WARNING(std::cout, "This is a warning");
+    TFMT_LOG_ERROR(std::cout, "This is an error");
+    TFMT_LOG_FATAL(std::cout, "This is a fatal error");
+}
+
+static void testLogPrefix() {
+    std::stringstream sstr;
+    tfmt::setLogPrefixFlags(tfmt::LogPrefixFlags::All);
+    for (int i = 0; i < 2; ++i) {
+        TFMT_LOG_INFO(sstr, "message");
+    }
+    tfmt::setLogPrefixFlags(tfmt::LogPrefixFlags::None);
+    std::string line;
+    while (std::getline(sstr, line)) {
+        // HH:MM:SS.mmm INFO  testdriver.cpp:<line> message
+        assert(line.size() > 13);
+        assert(line[2] == ':' && line[5] == ':' && line[8] == '.');
+        assert(line.substr(13, 6) == "INFO  ");
+        assert(line.substr(19, 15) == "testdriver.cpp:");
+        assert(line.ends_with(" message"));
+    }
+    // SVG streams show the prefix in its style
+    std::stringstream svgText;
+    {
+        tfmt::SVGStream svg(svgText);
+        TFMT_LOG_ERROR(svg, "message");
+    }
+    assert(svgText.str().find(
+               "fill=\"#cd3131\" font-weight=\"bold\">ERROR</text>") !=
+           std::string::npos);
+}
+
+static void testSVG() {
+    std::stringstream sstr;
+    tfmt::SVGStream svg(sstr);
+    svg << tfmt::format(tfmt::Red, "red") << " <plain>\n";
+    svg << tfmt::format(tfmt::Bold, "a") << tfmt::format(tfmt::Bold, "b");
+    svg.finish();
+    auto const text = sstr.str();
+    assert(text.starts_with("<svg "));
+    assert(text.ends_with("</svg>\n"));
+    // 11 columns of 8.4 pixels and 2 lines of 17.5 pixels
+    assert(text.find("width=\"0000000093\"") != std::string::npos);
+    assert(text.find("height=\"0000000035\"") != std::string::npos);
+    assert(text.find("fill=\"#cd3131\">red</text>") != std::string::npos);
+    assert(text.find("> &lt;plain&gt;</text>") != std::string::npos);
+    // Adjacent runs of the same style are merged
+    assert(text.find("font-weight=\"bold\">ab</text>") != std::string::npos);
+    // Colon separated subparameters are not mistaken for other codes
+    std::stringstream colon;
+    {
+        tfmt::SVGStream stream(colon);
+        stream << "\033[4:3mX\033[4:0mY\033[38:2::255:0:0mR";
+    }
+    auto const colonText = colon.str();
+    assert(colonText.find("text-decoration=\"underline\">X</text>") !=
+           std::string::npos);
+    assert(colonText.find("italic") == std::string::npos);
+    assert(colonText.find("\">Y</text>") != std::string::npos);
+    assert(colonText.find("fill=\"#ff0000\">R</text>") != std::string::npos);
+    // Wide characters take two columns and marks combine with their base,
+    // even if the input is split within code points
+    std::stringstream wide;
+    {
+        tfmt::SVGStream stream(wide);
+        std::string_view const text = "\u65E5\u672Ce\u0301|x";
+        for (char const c: text) {
+            stream.write(&c, 1);
+        }
+    }
+    auto const wideText = wide.str();
+    // 7 columns of 8.4 pixels
+    assert(wideText.find("width=\"0000000059\"") != std::string::npos);
+    assert(wideText.find("textLength=\"58.8\">\u65E5\u672Ce\u0301|x<") !=
+           std::string::npos);
+    // Long lines in one style are written while they arrive
+    std::stringstream longLine;
+    tfmt::SVGStream longStream(longLine);
+    longStream << std::string(20000, 'a');
+    assert(longLine.str().find("aaaa</text>") != std::string::npos);
+}
+
+static void testNumberFormatting() {
+    header(" Numbers ");
+    using tfmt::formatNumber;
+    using tfmt::NumberFormat;
+    using tfmt::NumberUnit;
+    assert(formatNumber(1234567).text() == "1234567");
+    assert(formatNumber(-1234567, { .grouping = true }).text() == "-1,234,567");
+    assert(formatNumber(1234.5678, { .precision = 2, .grouping = true })
+               .text() == "1,234.57");
+    assert(formatNumber(512, { .unit = NumberUnit::Bytes }).text() == "512 B");
+    assert(formatNumber(1536, { .unit = NumberUnit::Bytes }).text() ==
+           "1.5 KiB");
+    // Rounding to one decimal reaches the next unit
+    assert(formatNumber(1048575, { .unit = NumberUnit::Bytes }).text() ==
+           "1.0 MiB");
+    assert(formatNumber(999'999, { .unit = NumberUnit::SI }).text() ==
+           "1.0 M");
+    assert(formatNumber(1048063, { .unit = NumberUnit::Bytes }).text() ==
+           "1023.5 KiB");
+    assert(formatNumber(2'500'000, { .unit = NumberUnit::Nanoseconds })
+               .text() == "2.5 ms");
+    assert(formatNumber(42, { .precision = 2 }).text() == "42.00");
+    auto const aligned = formatNumber(7, { .width = 4 });
+    assert(aligned.width() == 4);
+    std::stringstream sstr;
+    sstr << aligned;
+    assert(sstr.str() == "   7");
+    tfmt::Threshold const thresholds[] = { { 0, &tfmt::Green },
+                                           { 100, &tfmt::Yellow },
+                                           { 1000, &tfmt::Red } };
+    assert(formatNumber(150, {}, thresholds).modifier() == &tfmt::Yellow);
+    for (double latency: { 12.0, 345.0, 6789.0 }) {
+        std::cout << formatNumber(latency * 1000,
+                                  { .unit = NumberUnit::Nanoseconds,
+                                    .width = 10 },
+                                  thresholds)
+                  << "\n";
+    }
+}
+
+static void testTargetedPop() {
+    std::stringstream sstr;
+    tfmt::setTermFormattable(sstr);
+    tfmt::pushModifier(tfmt::Red | tfmt::Bold, sstr);
+    tfmt::pushModifier(tfmt::Underline, sstr);
+    tfmt::pushModifier(tfmt::Blue, sstr);
+    tfmt::pushModifier(tfmt::Blue, sstr);
+    sstr << "x";
+    tfmt::popModifier(sstr);
+    tfmt::popModifier(sstr);
+    tfmt::popModifier(sstr);
+    tfmt::popModifier(sstr);
+    // The first push emits the codes of the modifier, further pushes emit
+    // only the changed attributes and popping emits targeted off codes
+    assert(sstr.str() == "\033[31m\033[1m"
+                         "\033[4m"
+                         "\033[34m"
+                         "x"
+                         "\033[31m"
+                         "\033[24m"
+                         "\033[22;39m");
+    // Custom modifiers with codes that transitions don't track, like the
+    // overline, are written as they are, and only a reset undoes them
+    tfmt::Modifier const overline("\033[53m", "");
+    auto render = [](auto const&... objects) {
+        std::stringstream stream;
+        tfmt::setTermFormattable(stream);
+        stream << tfmt::format(objects...);
+        return stream.str();
+    };
+    assert(render(overline, "a", tfmt::format(tfmt::Bold, "b"), "c") ==
+           "\033[53ma\033[1mb\033[22mc\033[0m");
+    assert(render(tfmt::Bold, "a", tfmt::format(overline, "b"), "c") ==
+           "\033[1ma\033[53mb\033[00m\033[1mc\033[22m");
+    assert(render(overline, "a", tfmt::format(tfmt::Reset, "b"), "c") ==
+           "\033[53ma\033[00mb\033[00m\033[53mc\033[0m");
+}
+
+namespace {
+
+enum class Status { Ok, Failed };
+
+std::ostream& operator<<(std::ostream& ostream, Status status) {
+    return ostream << (status == Status::Ok ? "ok" : "failed");
+}
+
+tfmt::Modifier const& tfmt_style(Status status) {
+    return status == Status::Ok ? tfmt::Green : tfmt::Red;
+}
+
+} // namespace
+
+static void testStyleTraits() {
+    static_assert(tfmt::Styleable<Status>);
+    static_assert(!tfmt::Styleable<int>);
+    std::stringstream sstr;
+    tfmt::setTermFormattable(sstr);
+    tfmt::pushModifier(tfmt::Bold, sstr);
+    sstr << tfmt::styled(Status::Ok) << tfmt::styled(Status::Failed);
+    tfmt::popModifier(sstr);
+    assert(sstr.str() == "\033[1m"
+                         "\033[32mok\033[39m"
+                         "\033[31mfailed\033[39m"
+                         "\033[22m");
+}
+
+static void testJoin() {
+    std::vector<int> values = { 1, 2, -3, -4, 5 };
+    auto style = [](int value) -> tfmt::Modifier const& {
+        return value < 0 ? tfmt::Red : tfmt::Green;
+    };
+    std::stringstream sstr;
+    tfmt::setTermFormattable(sstr);
+    sstr << tfmt::join(values, ", ", style);
+    // Equally styled neighbours share one run, separators between runs are
+    // unstyled
+    assert(sstr.str() == "\033[32m1, 2\033[39m, "
+                         "\033[31m-3, -4\033[39m, "
+                         "\033[32m5\033[39m");
+    std::stringstream plain;
+    plain << tfmt::join(values, '|', style);
+    assert(plain.str() == "1|2|-3|-4|5");
+    std::stringstream traits;
+    tfmt::setTermFormattable(traits);
+    Status const statuses[] = { Status::Ok, Status::Failed };
+    traits << tfmt::join(statuses, " ") << tfmt::join(values, "");
+    assert(traits.str() == "\033[32mok\033[39m \033[31mfailed\033[39m"
+                           "12-3-45");
+    std::stringstream empty;
+    empty << tfmt::join(std::vector<int>{}, ", ");
+    assert(empty.str().empty());
+}
+
+static void testAnimation() {
+    using namespace std::chrono_literals;
+    std::stringstream sstr;
+    tfmt::setTermFormattable(sstr);
+    {
+        tfmt::AnimationScheduler scheduler(sstr, 1ms);
+        tfmt::Spinner a(tfmt::None, { .interval = 2ms }, scheduler);
+        tfmt::Spinner b(tfmt::None, { .interval = 2ms, .row = 1 }, scheduler);
+        assert(a.isRunning() && b.isRunning());
+        std::this_thread::sleep_for(50ms);
+        b.stop();
+        a.stop();
+        assert(!a.isRunning());
+    }
+    auto const text = sstr.str();
+    // Frames of both spinners are due in the same tick and written together
+    assert(text.starts_with("\0337\r⠋\0338\0337\033[1A\r⠋\0338"));
+    assert(text.find("⠙") != std::string::npos);
+    // Stopped spinners are cleared
+    assert(text.ends_with("\0337\033[1A\r \0338\0337\r \0338"));
+    // Frames identical to the one on screen are not written again
+    std::stringstream idle;
+    tfmt::setTermFormattable(idle);
+    {
+        tfmt::AnimationScheduler scheduler(idle, 1ms);
+        std::string_view const frames[] = { "a", "a" };
+        tfmt::Animation animation(frames,
+                                  tfmt::None,
+                                  { .interval = 1ms, .clearOnStop = false },
+                                  scheduler);
+        std::this_thread::sleep_for(20ms);
+        animation.stop();
+        auto const stats = scheduler.stats();
+        assert(stats.frames > 1);
+        assert(stats.suppressedFrames == stats.frames - 1);
+        assert(stats.bytesWritten == 6);
+        assert(stats.bytesSuppressed == 6 * stats.suppressedFrames);
+    }
+    assert(idle.str() == "\0337\ra\0338");
+    // Animations are not drawn to streams that are not term formattable
+    std::stringstream plain;
+    {
+        tfmt::AnimationScheduler scheduler(plain, 1ms);
+        tfmt::Spinner spinner(tfmt::None, {}, scheduler);
+        assert(!spinner.isRunning());
+    }
+    assert(plain.str().empty());
+}
+
+static void testTable() {
+    std::stringstream sstr;
+    {
+        tfmt::TableWriter table(sstr, { "id", "name" }, { .sampleSize = 2 });
+        table.addRow({ "1", "\033[31mred\033[0m" });
+        table.addRow({ "22", "x" });
+        // The widths are fixed now, this row is printed immediately
+        assert(table.columnWidths()[1] == 4);
+        table.addRow({ "333", "abcdef" });
+        assert(sstr.str().ends_with("3…  abc…\n"));
+    }
+    assert(sstr.str() == "id  name\n"
+                         "1   \033[31mred\033[0m\n"
+                         "22  x\n"
+                         "3…  abc…\n");
+    std::stringstream expand;
+    {
+        tfmt::TableWriter table(expand,
+                                {},
+                                { .sampleSize = 1,
+                                  .overflow = tfmt::TableOverflow::Expand });
+        table.addRow({ "a", "b" });
+        table.addRow({ "long", "b" });
+        table.addRow({ "c", "d", "dropped" });
+    }
+    assert(expand.str() == "a  b\n"
+                           "long  b\n"
+                           "c     d\n");
+    std::stringstream fitted;
+    {
+        tfmt::TableWriter table(fitted,
+                                { "n", "text" },
+                                { .maxTableWidth = 10,
+                                  .alignment = { tfmt::TableAlign::Right } });
+        table.addRow({ "1", "a very long cell" });
+        table.addRow({ "100", "b" });
+    }
+    // The widest column is narrowed to fit 10 columns
+    assert(fitted.str() == "  n  text\n"
+                           "  1  a ve…\n"
+                           "100  b\n");
+    // Under a width limit the header and all rows share the fitted widths
+    for (auto overflow:
+         { tfmt::TableOverflow::Truncate, tfmt::TableOverflow::Expand })
+    {
+        std::stringstream limited;
+        {
+            tfmt::TableWriter table(limited,
+                                    { "name", "description", "n" },
+                                    { .sampleSize = 1,
+                                      .maxTableWidth = 20,
+                                      .overflow = overflow });
+            table.addRow({ "a", std::string(40, 'x'), "1" });
+            table.addRow({ "b", std::string(40, 'y'), "2" });
+            table.addRow({ "c", "short", "3" });
+        }
+        std::vector<std::string> lines;
+        for (std::string line; std::getline(limited, line);) {
+            lines.push_back(line);
+        }
+        assert(lines.size() == 4);
+        bool const truncate = overflow == tfmt::TableOverflow::Truncate;
+        // The last column starts in the same column in every line
+        auto lastColumn = [](std::string_view line) {
+            return tfmt::displayWidth(line.substr(0, line.rfind(' ') + 1));
+        };
+        assert(lastColumn(lines[0]) == (truncate ? 19 : 48));
+        for (auto& line: lines) {
+            assert(lastColumn(line) == lastColumn(lines[0]));
+            assert(!truncate || tfmt::displayWidth(line) <= 20);
+        }
+    }
+}
+
+static void testFlameGraph() {
+    tfmt::FlameGraph graph;
+    auto const malformed = graph.parseFolded("main;parse;lex 2\n"
+                                             "main;parse 1\n"
+                                             "\n"
+                                             "main;eval 1\r\n"
+                                             "garbage\n");
+    assert(malformed == 1);
+    assert(graph.totalSamples() == 4);
+    std::stringstream sstr;
+    graph.render(sstr, { .width = 8 });
+    // Frames are sorted by name and get columns proportional to their
+    // samples
+    assert(sstr.str() == "main    \n"
+                         "e…parse \n"
+                         "  lex \n");
+}
+
+static void testHistogram() {
+    tfmt::Histogram histogram;
+    for (int i = 1; i <= 1000; ++i) {
+        histogram.add(i);
+    }
+    auto const& sketch = histogram.quantiles();
+    assert(sketch.count() == 1000);
+    assert(sketch.min() == 1 && sketch.max() == 1000);
+    // Quantiles are within the relative accuracy of 1%
+    assert(std::abs(sketch.quantile(0.5) - 500) <= 5);
+    assert(std::abs(sketch.quantile(0.99) - 990) <= 10);
+    assert(sketch.quantile(0) == 1 && sketch.quantile(1) == 1000);
+    std::stringstream sstr;
+    static constexpr double Percentiles[] = { 50 };
+    histogram.render(sstr,
+                     { .bins = 4,
+                       .width = 30,
+                       .logScale = false,
+                       .percentiles = Percentiles });
+    auto const text = sstr.str();
+    assert(std::count(text.begin(), text.end(), '\n') == 5);
+    assert(text.starts_with("  1.0 │"));
+    assert(text.find("\n500.5 │") != std::string::npos);
+    assert(text.ends_with("p50 497.8\n"));
+}
+
+static void testSharedOutput() {
+    std::string const name = "test-" + std::to_string(std::time(nullptr));
+    std::FILE* file = std::tmpfile();
+    int const fd = fileno(file);
+    {
+        // Two channels with the same name stand in for two processes
+        tfmt::SharedOutput first(name, { .capacity = 64, .fd = fd });
+        tfmt::SharedOutput second(name, { .fd = fd });
+        assert(!first.isShared() || first.isLeader() != second.isLeader());
+        auto produce = [](tfmt::SharedOutput& output, char c) {
+            tfmt::SharedOutputStream stream(output);
+            for (int i = 0; i < 200; ++i) {
+                stream << tfmt::Bold << std::string(10, c) << tfmt::Reset
+                       << '\n';
+            }
+        };
+        std::thread a(produce, std::ref(first), 'a');
+        std::thread b(produce, std::ref(second), 'b');
+        a.join();
+        b.join();
+        // The line break is appended in the same slot as the line, also
+        // where the line wraps around the end of the ring
+        for (int i = 0; i < 20; ++i) {
+            second.submit("ddddd");
+        }
+        // Oversized lines bypass the ring
+        first.submit(std::string(100, 'c'));
+        first.flush();
+        second.flush();
+    }
+    tfmt::SharedOutput::remove(name);
+    std::rewind(file);
+    std::string line;
+    int count = 0;
+    for (int c; (c = std::fgetc(file)) != EOF;) {
+        if (c != '\n') {
+            line += static_cast<char>(c);
+            continue;
+        }
+        // Lines never interleave
+        assert(line == std::string(10, 'a') || line == std::string(10, 'b') ||
+               line == std::string(100, 'c') || line == "ddddd");
+        line.clear();
+        ++count;
+    }
+    assert(count == 421);
+    std::fclose(file);
+}
+
+static void testWrap() {
+    using tfmt::WrapMode;
+    std::string_view const text = "aaa bb cc ddddd";
+    assert(tfmt::wrap(text, { .width = 6 }) == "aaa bb\ncc\nddddd");
+    // The optimal breaks avoid the short middle line
+    assert(tfmt::wrap(text, { .width = 6, .mode = WrapMode::Optimal }) ==
+           "aaa\nbb cc\nddddd");
+    assert(tfmt::wrap("a b c\n\nd", { .width = 4, .indent = 1 }) ==
+           " a b\n c\n\n d");
+    assert(tfmt::wrap("a bb ccc", { .width = 5, .justify = true }) ==
+           "a  bb\nccc");
+    // Styles are undone before a break and restored after it
+    assert(tfmt::wrap("\033[1maa bb\033[0m", { .width = 3 }) ==
+           "\033[1maa\033[22m\n\033[1mbb\033[0m");
+}
+
+static void testTabs() {
+    assert(tfmt::expandTabs("a\tb\n\tc", { .tabWidth = 4 }) ==
+           "a   b\n    c");
+    // Escape sequences occupy no columns, wide characters two
+    assert(tfmt::expandTabs("\033[1mab\033[0m\tc", { .tabWidth = 4 }) ==
+           "\033[1mab\033[0m  c");
+    assert(tfmt::expandTabs("\u65e5\tx", { .tabWidth = 4 }) ==
+           "\u65e5  x");
+    static constexpr std::size_t Stops[] = { 3, 5 };
+    assert(tfmt::expandTabs("\t\t\t\tx",
+                            { .tabWidth = 2, .stops = Stops }) ==
+           std::string(9, ' ') + "x");
+    // Carriage returns return to column zero
+    assert(tfmt::expandTabs("abcdef\rx\ty", { .tabWidth = 4 }) ==
+           "abcdef\rx   y");
+    // The stops are copied, so they may be temporary
+    tfmt::TabExpander stopsExpander(
+        { .tabWidth = 8, .stops = std::vector<std::size_t>{ 2, 5 } });
+    std::string stopsOut;
+    stopsExpander.expand("\ta\tb\tc", stopsOut);
+    assert(stopsOut == "  a  b       c");
+    // The column is carried across chunks
+    tfmt::TabExpander expander({ .tabWidth = 4 });
+    std::string out;
+    expander.expand("a", out);
+    expander.expand("b\tc", out);
+    assert(out == "ab  c" && expander.column() == 5);
+    // Long lines without spaces are measured while they arrive, without
+    // splitting wide characters or escape sequences across chunks
+    std::string line;
+    for (int i = 0; i < 2000; ++i) {
+        line += "\033[31m\u65e5\033[0m";
+    }
+    expander.reset();
+    out.clear();
+    for (std::size_t i = 0; i < line.size(); i += 7) {
+        expander.expand(std::string_view(line).substr(i, 7), out);
+    }
+    assert(expander.column() == 4000);
+    expander.expand("\tx", out);
+    assert(out == line + "    x");
+    std::stringstream sstr;
+    {
+        tfmt::TabStream stream(sstr, { .tabWidth = 4 });
+        stream << "x\ty" << '\t' << "z";
+    }
+    assert(sstr.str() == "x   y   z");
+    // Tabs in table cells are expanded relative to the cell
+    std::stringstream table;
+    {
+        tfmt::TableWriter writer(table, {}, { .tabWidth = 4 });
+        writer.addRow({ "a\tb", "c" });
+    }
+    assert(table.str() == "a   b  c\n");
+}
+
+static void testAnsiParser() {
+    using tfmt::AnsiEventKind;
+    std::string_view const text = "ab\033[1;31mc\n\033]8;;url\033\\d\033[2J";
+    std::vector<AnsiEventKind> kinds;
+    std::string plain;
+    // Feed the text in chunks of every size, so every sequence is split at
+    // every position
+    for (std::size_t size = 1; size <= text.size(); ++size) {
+        tfmt::AnsiParser parser;
+        kinds.clear();
+        plain.clear();
+        for (std::size_t i = 0; i < text.size(); i += size) {
+            parser.feed(text.substr(i, size));
+            while (auto event = parser.next()) {
+                if (event->kind == AnsiEventKind::Text) {
+                    plain += event->text;
+                    continue;
+                }
+                kinds.push_back(event->kind);
+                switch (event->kind) {
+                case AnsiEventKind::Style:
+                    assert(event->params.size() == 2);
+                    assert(event->params[0] == 1 && event->params[1] == 31);
+                    break;
+                case AnsiEventKind::OSC:
+                    assert(event->text == "8;;url");
+                    break;
+                case AnsiEventKind::CSI:
+                    assert(event->text == "2" && event->final == 'J');
+                    break;
+                default:
+                    break;
+                }
+            }
+        }
+        assert(plain == "abcd");
+        assert((kinds == std::vector{ AnsiEventKind::Style,
+                                      AnsiEventKind::Control,
+                                      AnsiEventKind::OSC,
+                                      AnsiEventKind::CSI }));
+    }
+}
+
+static void testSGROptimizer() {
+    std::string_view const text =
+        "\033[31m\033[0m\033[1ma\033[0m\033[1mb\033[0m\033[4:3mc\033[0m\n"
+        "\033[32mx\033[0m\033[32my\033[39m";
+    std::string_view const expected =
+        "\033[1mab\033[m\033[4:3mc\033[0m\n\033[32mxy\033[m";
+    for (std::size_t size = 1; size <= text.size(); ++size) {
+        tfmt::SGROptimizer optimizer;
+        std::string out;
+        for (std::size_t i = 0; i < text.size(); i += size) {
+            optimizer.optimize(text.substr(i, size), out);
+        }
+        optimizer.finish(out);
+        assert(out == expected);
+        assert(optimizer.bytesIn() == text.size());
+        assert(optimizer.bytesOut() == expected.size());
+    }
+    std::stringstream sstr;
+    {
+        tfmt::SGROptimizingStream stream(sstr);
+        stream << text;
+    }
+    assert(sstr.str() == expected);
+    auto optimize = [](std::string_view input) {
+        tfmt::SGROptimizer optimizer;
+        std::string out;
+        optimizer.optimize(input, out);
+        optimizer.finish(out);
+        return out;
+    };
+    // The reset of an untracked overline is kept
+    assert(optimize("\033[53mX\033[0mY") == "\033[53mX\033[0mY");
+    assert(optimize("\033[53mX\033[1m\033[0mY") ==
+           "\033[53mX\033[1m\033[0mY");
+    // Colors with colon separated subparameters are tracked
+    assert(optimize("\033[38:2::255:0:0mR\033[39mD") ==
+           "\033[38;2;255;0;0mR\033[mD");
+    assert(optimize("\033[48:5:4mR\033[44mD\033[49m") ==
+           "\033[48;5;4mR\033[44mD\033[m");
+    // An incomplete sequence at the end of the input is kept
+    tfmt::SGROptimizer truncated;
+    std::string truncatedOut;
+    truncated.optimize("\033[31mA\033[0m\033[", truncatedOut);
+    truncated.finish(truncatedOut);
+    assert(truncatedOut == "\033[31mA\033[m\033[");
+    assert(truncated.bytesOut() == truncatedOut.size());
+    // Flushing keeps a split sequence, so its style is tracked
+    std::stringstream split;
+    {
+        tfmt::SGROptimizingStream stream(split);
+        stream << "\033[" << std::flush << "31mA\033[0mB";
+    }
+    assert(split.str() == "\033[31mA\033[mB");
+    // Unknown subparameters are skipped with their group
+    assert(optimize("\033[4:3;1mX\033[4:0;22mY") ==
+           "\033[4:3;1mX\033[4:0;22mY");
+}
+
+static void testSanitize() {
+    std::string_view const text =
+        "a\033[31mb\033]0;title\007c\td\n\x7F\xC2\x9B" "31m\xC2\xA9";
+    assert(tfmt::sanitize(text) == "abc\td\n31m\xC2\xA9");
+    tfmt::SanitizeOptions options;
+    options.mode = tfmt::SanitizeMode::Caret;
+    assert(tfmt::sanitize(text, options) ==
+           "a^[[31mb^[]0;title^Gc\td\n^?M-^[31m\xC2\xA9");
+    options = {};
+    options.allowStyles = true;
+    assert(tfmt::sanitize(text, options) ==
+           "a\033[31mbc\td\n31m\xC2\xA9\033[m");
+    // Incomplete sequences are removed up to the end
+    assert(tfmt::sanitize("a\033]8;;") == "a");
+    // Untrusted arguments of format()
+    std::stringstream sstr;
+    tfmt::setTermFormattable(sstr);
+    sstr << tfmt::format(tfmt::Bold, "x", tfmt::untrusted("\033[2Jy\r"));
+    std::stringstream expected;
+    tfmt::setTermFormattable(expected);
+    expected << tfmt::format(tfmt::Bold, "x", "y");
+    assert(sstr.str() == expected.str());
+    // Styles are only allowed on formattable streams
+    std::stringstream plain;
+    plain << tfmt::untrusted("\033[1mz", options);
+    assert(plain.str() == "z");
+}
+
+namespace {
+
+struct Nested {};
+
+std::ostream& operator<<(std::ostream& ostream, Nested) {
+    return ostream << "<" << tfmt::toString(tfmt::format(tfmt::Red, 1)) << ">";
+}
+
+/// Groups digits by thousands with apostrophes
+struct ApostropheGrouping: std::numpunct<char> {
+    char do_thousands_sep() const override { return '\''; }
+    std::string do_grouping() const override { return "\3"; }
+};
+
+} // namespace
+
+static void testPooledStringStream() {
+    std::stringstream expected;
+    tfmt::setTermFormattable(expected);
+    expected << tfmt::format(tfmt::Bold, "x", 42);
+    assert(tfmt::toString(tfmt::format(tfmt::Bold, "x", 42)) ==
+           expected.str());
+    std::ostream* first = nullptr;
+    {
+        tfmt::PooledStringStream stream;
+        first = &*stream;
+        *stream << std::hex << std::setw(4) << 255;
+        tfmt::setHTMLFormattable(*stream);
+        assert(stream.view() == "  ff");
+    }
+    {
+        // The stream is reused with its initial state restored
+        tfmt::PooledStringStream stream;
+        assert(&*stream == first);
+        *stream << 255;
+        assert(stream.view() == "255");
+        assert(tfmt::isTermFormattable(*stream));
+        assert(!tfmt::isHTMLFormattable(*stream));
+    }
+    {
+        // Leave a locale, an exception mask and a modifier behind
+        tfmt::PooledStringStream stream;
+        stream->imbue(std::locale(stream->getloc(), new ApostropheGrouping));
+        stream->exceptions(std::ios_base::badbit);
+        tfmt::pushModifier(tfmt::Underline, *stream);
+        *stream << 1234567;
+        assert(stream.view() == "\033[4m1'234'567");
+    }
+    std::stringstream grouped;
+    tfmt::setTermFormattable(grouped);
+    grouped << tfmt::format(tfmt::Bold, 1234567);
+    {
+        tfmt::PooledStringStream stream;
+        assert(stream->getloc() == std::locale());
+        assert(stream->exceptions() == std::ios_base::goodbit);
+        *stream << tfmt::format(tfmt::Bold, 1234567);
+        assert(stream.view() == grouped.str());
+        assert(tfmt::internal::currentAttributes(*stream) ==
+               tfmt::internal::Attributes{});
+    }
+    // Pooled streams can be used while formatting into another one
+    std::stringstream nested;
+    tfmt::setTermFormattable(nested);
+    nested << tfmt::format(tfmt::Red, 1);
+    assert(tfmt::toString(Nested{}, '.') == "<" + nested.str() + ">.");
+    std::string const large(100000, 'a');
+    assert(tfmt::toString(large, large).size() == 2 * large.size());
+}
+
+static void testStyledBuilder() {
+    using namespace tfmt::modifiers;
+    std::string out = "> ";
+    unsigned char const letter = 'A';
+    tfmt::appendStyled(out, Bold | Red, "x", 42, '!', 3.14159265, letter, 1e7);
+    std::stringstream expected;
+    tfmt::setTermFormattable(expected);
+    expected << "> "
+             << tfmt::format(Bold | Red, "x", 42, '!', 3.14159265, letter, 1e7);
+    assert(out == expected.str());
+    // Nested modifiers emit the same codes as on a stream
+    out.clear();
+    expected.str("");
+    {
+        tfmt::StyledBuilder builder(out);
+        // Pushed modifiers may be temporaries
+        builder.push(Bold | Underline);
+        builder << "a";
+        builder.appendStyled(Green, "b");
+        builder.push(Italic);
+        builder << "c";
+        // The remaining modifiers are popped on destruction
+    }
+    {
+        tfmt::FormatGuard<std::ostream> bold(Bold | Underline, expected);
+        expected << "a" << tfmt::format(Green, "b");
+        tfmt::FormatGuard<std::ostream> italic(Italic, expected);
+        expected << "c";
+    }
+    assert(out == expected.str());
+    // Fixed arrays
+    std::array<char, 16> buffer;
+    tfmt::StyledBuilder builder(buffer);
+    builder << "ab";
+    builder.appendStyled(Bold, "cd");
+    assert(!builder.truncated());
+    assert(builder.view() == "ab\033[1mcd\033[22m");
+    // Text is cut at a code point boundary
+    builder << "xy\xC3\xA9";
+    assert(builder.truncated());
+    assert(builder.view() == "ab\033[1mcd\033[22mxy");
+    // Room for undoing the pushed modifiers is kept
+    std::array<char, 10> small;
+    {
+        tfmt::StyledBuilder full(small);
+        full.push(Bold);
+        full << "abcdefgh";
+        full.push(Red);
+        full.pop();
+        full.pop();
+        assert(full.truncated());
+        assert(full.view() == "\033[1ma\033[22m");
+    }
+}
+
+namespace {
+
+/// Counts how often it is inserted
+struct InsertionCounter {
+    int* count;
+};
+
+std::ostream& operator<<(std::ostream& ostream, InsertionCounter counter) {
+    ++*counter.count;
+    return ostream << "!";
+}
+
+} // namespace
+
+static void testPrerendered() {
+    using namespace tfmt::modifiers;
+    int count = 0;
+    tfmt::Prerendered const fragment(Bold | Red,
+                                     "error",
+                                     InsertionCounter{ &count });
+    auto check = [&](std::ostream& actual, std::ostream& expected) {
+        for (int i = 0; i < 3; ++i) {
+            actual << fragment;
+            expected << tfmt::format(Bold | Red, "error", "!");
+        }
+    };
+    std::stringstream plain, plainExpected;
+    check(plain, plainExpected);
+    assert(plain.str() == plainExpected.str());
+    assert(count == 1);
+    std::stringstream term, termExpected;
+    tfmt::setTermFormattable(term);
+    tfmt::setTermFormattable(termExpected);
+    check(term, termExpected);
+    assert(term.str() == termExpected.str());
+    assert(count == 2);
+    // Inside of other modifiers the fragment transitions from their
+    // attributes
+    term.str("");
+    termExpected.str("");
+    {
+        tfmt::FormatGuard<std::ostream> guard(Bold | Green, term);
+        tfmt::FormatGuard<std::ostream> expectedGuard(Bold | Green,
+                                                      termExpected);
+        check(term, termExpected);
+    }
+    assert(term.str() == termExpected.str());
+    assert(count == 3);
+    std::stringstream html, htmlExpected;
+    tfmt::setHTMLFormattable(html);
+    tfmt::setHTMLFormattable(htmlExpected);
+    check(html, htmlExpected);
+    assert(html.str() == htmlExpected.str());
+    assert(count == 4);
+    // All `MaxRenderings` slots are taken by the four streams above, so the
+    // SVG stream gets no cached rendering and each of its three insertions
+    // renders the fragment again
+    std::stringstream svg, svgExpected;
+    tfmt::setSVGFormattable(svg);
+    tfmt::setSVGFormattable(svgExpected);
+    check(svg, svgExpected);
+    assert(svg.str() == svgExpected.str());
+    assert(count == 7);
+    // Fragments are rendered with the format state of the stream
+    tfmt::Prerendered const number(Bold, 255);
+    std::stringstream hex, hexExpected;
+    hex << std::hex << std::setw(4) << std::setfill('0') << number << 255;
+    hexExpected << std::hex << std::setw(4) << std::setfill('0')
+                << tfmt::format(Bold, 255) << 255;
+    assert(hex.str() == "00ffff");
+    assert(hex.str() == hexExpected.str());
+    hex.str("");
+    hex << std::dec << number;
+    assert(hex.str() == "255");
+}
+
+static void testLiveView() {
+    std::stringstream sstr;
+    tfmt::setTermFormattable(sstr);
+    tfmt::LiveView view(sstr);
+    auto update = [&](std::string_view frame) {
+        sstr.str("");
+        view.update(frame);
+        return sstr.str();
+    };
+    assert(update("a\nb\n") == "\033[Ka\n\033[Kb\n");
+    // Only the changed line is rewritten
+    assert(update("a\nc") == "\033[2F\033[E\033[Kc\n");
+    // Identical frames are not written at all
+    assert(update("a\nc") == "");
+    assert(update("a") == "\033[2F\033[E\033[J");
+    assert(update("\033[1mb\033[22m\nd") ==
+           "\033[F\033[K\033[1mb\033[22m\033[m\n\033[Kd\n");
+    auto const& stats = view.stats();
+    assert(stats.frames == 5);
+    assert(stats.suppressedFrames == 1);
+    assert(stats.suppressedLines == 4);
+    assert(stats.bytesWritten == 10 + 12 + 10 + 25);
+    // Lines are cut to the width of the stream. They are erased before the
+    // text, because a terminal erases the last column otherwise.
+    tfmt::setWidth(sstr, 3);
+    assert(update("abcdef\nd") == "\033[2F\033[Kabc\n\033[E");
+    // Streams that are not formattable get every distinct frame
+    std::stringstream plain;
+    tfmt::LiveView plainView(plain);
+    plainView.update("x\n");
+    plainView.update("x\n");
+    plainView.update("y\n");
+    assert(plain.str() == "x\ny\n");
+    assert(plainView.stats().suppressedFrames == 1);
+    assert(plainView.stats().bytesSuppressed == 2);
+}
+
+namespace {
+
+/// Image decoded from a sixel sequence
+struct SixelDecoded {
+    std::size_t width = 0, height = 0;
+    /// `0xRRGGBB` or -1 for pixels that are not painted
+    std::vector<long> pixels;
+};
+
+/// Decodes the sixel sequences written by `tfmt::SixelEncoder`
+SixelDecoded decodeSixel(std::string_view data) {
+    assert(data.starts_with("\033P0;1;0q"));
+    assert(data.ends_with("\033\\"));
+    data = data.substr(8, data.size() - 10);
+    auto number = [&] {
+        std::size_t value = 0;
+        auto result =
+            std::from_chars(data.data(), data.data() + data.size(), value);
+        data.remove_prefix(static_cast<std::size_t>(result.ptr - data.data()));
+        return value;
+    };
+    auto skip = [&](char c) {
+        assert(!data.empty() && data.front() == c);
+        data.remove_prefix(1);
+    };
+    SixelDecoded image;
+    skip('"');
+    number();
+    skip(';');
+    number();
+    skip(';');
+    image.width = number();
+    skip(';');
+    image.height = number();
+    image.pixels.assign(image.width * image.height, -1);
+    std::vector<long> palette(256);
+    std::size_t color = 0, x = 0, top = 0;
+    auto paint = [&](char sixel, std::size_t count) {
+        for (; count > 0; --count, ++x) {
+            for (std::size_t row = 0; row < 6; ++row) {
+                if ((sixel - '?') >> row & 1) {
+                    assert(x < image.width && top + row < image.height);
+                    image.pixels[(top + row) * image.width + x] =
+                        palette[color];
+                }
+            }
+        }
+    };
+    while (!data.empty()) {
+        char const c = data.front();
+        data.remove_prefix(1);
+        if (c == '#') {
+            color = number();
+            if (data.starts_with(";2;")) {
+                data.remove_prefix(3);
+                long rgb = 0;
+                for (int channel = 0; channel < 3; ++channel) {
+                    if (channel > 0) {
+                        skip(';');
+                    }
+                    rgb = rgb << 8 | static_cast<long>(number() * 255 / 100);
+                }
+                palette[color] = rgb;
+            }
+        }
+        else if (c == '!') {
+            std::size_t const count = number();
+            char const sixel = data.front();
+            data.remove_prefix(1);
+            paint(sixel, count);
+        }
+        else if (c == '$') {
+            x = 0;
+        }
+        else if (c == '-') {
+            x = 0;
+            top += 6;
+        }
+        else {
+            assert(c >= '?' && c <= '~');
+            paint(c, 1);
+        }
+    }
+    return image;
+}
+
+} // namespace
+
+static void testSixel() {
+    // 13 x 8 pixels: four horizontal stripes of solid colors and a
+    // transparent rectangle
+    std::size_t const width = 13, height = 8;
+    std::uint32_t const colors[] = { 0xFF0000, 0x00FF00, 0x2040C0, 0xFFFFFF };
+    std::vector<std::uint8_t> pixels;
+    for (std::size_t y = 0; y < height; ++y) {
+        for (std::size_t x = 0; x < width; ++x) {
+            std::uint32_t const color = colors[y / 2];
+            bool const transparent = x >= 4 && x < 7 && y >= 3 && y < 6;
+            pixels.push_back(static_cast<std::uint8_t>(color >> 16));
+            pixels.push_back(static_cast<std::uint8_t>(color >> 8));
+            pixels.push_back(static_cast<std::uint8_t>(color));
+            pixels.push_back(transparent ? 0 : 255);
+        }
+    }
+    tfmt::SixelImage const image{ pixels, width, height, 4 };
+    tfmt::SixelEncoder encoder;
+    std::string data;
+    encoder.encode(image, data);
+    assert(encoder.palette().size() == 4);
+    // Solid rows are run length encoded
+    assert(data.find("!13") != std::string::npos);
+    auto const decoded = decodeSixel(data);
+    assert(decoded.width == width && decoded.height == height);
+    for (std::size_t y = 0; y < height; ++y) {
+        for (std::size_t x = 0; x < width; ++x) {
+            long const pixel = decoded.pixels[y * width + x];
+            if (x >= 4 && x < 7 && y >= 3 && y < 6) {
+                assert(pixel == -1);
+                continue;
+            }
+            // Sixel colors are given in percent
+            long const expected = colors[y / 2];
+            for (int shift = 0; shift < 24; shift += 8) {
+                long const diff =
+                    (pixel >> shift & 0xFF) - (expected >> shift & 0xFF);
+                assert(diff >= -3 && diff <= 3);
+            }
+        }
+    }
+    // The palette of the next frame with the same colors is cached
+    std::string next;
+    encoder.encode(image, next);
+    assert(encoder.cacheHits() == 1);
+    assert(next == data);
+    // Fewer palette colors than image colors
+    tfmt::SixelEncoder small({ .maxColors = 2 });
+    data.clear();
+    small.encode(image, data);
+    assert(small.palette().size() == 2);
+    assert(decodeSixel(data).pixels.size() == width * height);
+}
+
 int main() {
     testRaw();
     testFormatGuard();
     testFlagAssociation();
     testStackAssociation();
     testFormatCallback();
+    testDisplayWidth();
+    testBacktrace();
+    testLogLevels();
+    testLogPrefix();
+    testSVG();
+    testNumberFormatting();
+    testTargetedPop();
+    testStyleTraits();
+    testJoin();
+    testAnimation();
+    testTable();
+    testFlameGraph();
+    testHistogram();
+    testSharedOutput();
+    testWrap();
+    testTabs();
+    testAnsiParser();
+    testSGROptimizer();
+    testSanitize();
+    testPooledStringStream();
+    testStyledBuilder();
+    testPrerendered();
+    testLiveView();
+    testSixel();
 }
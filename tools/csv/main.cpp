@@ -0,0 +1,506 @@
+// tfmt-csv: Print CSV and TSV files as styled tables
+//
+// Usage: tfmt-csv [-d <delimiter>] [-n <sample rows>] [--no-header] <file>
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define TFMT_CSV_SSE2 1
+#else
+#define TFMT_CSV_SSE2 0
+#endif
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <termfmt/number.h>
+#include <termfmt/table.h>
+#include <termfmt/termfmt.h>
+
+namespace {
+
+/// Read only memory mapping of a whole file
+class MappedFile {
+public:
+    explicit MappedFile(char const* path) {
+#if defined(_WIN32)
+        file = CreateFileA(path,
+                           GENERIC_READ,
+                           FILE_SHARE_READ,
+                           nullptr,
+                           OPEN_EXISTING,
+                           FILE_FLAG_SEQUENTIAL_SCAN,
+                           nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            return;
+        }
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize)) {
+            return;
+        }
+        size = static_cast<size_t>(fileSize.QuadPart);
+        if (size == 0) {
+            isOpen = true;
+            return;
+        }
+        mapping =
+            CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping) {
+            return;
+        }
+        data = static_cast<char const*>(
+            MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        if (!data) {
+            return;
+        }
+#else
+        fd = open(path, O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            return;
+        }
+        size = static_cast<size_t>(info.st_size);
+        if (size == 0) {
+            isOpen = true;
+            return;
+        }
+        void* addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED) {
+            return;
+        }
+        // The file is scanned front to back once, so the kernel can read
+        // ahead aggressively and drop pages behind us
+        madvise(addr, size, MADV_SEQUENTIAL);
+        data = static_cast<char const*>(addr);
+#endif
+        isOpen = true;
+    }
+
+    MappedFile(MappedFile const&) = delete;
+    MappedFile& operator=(MappedFile const&) = delete;
+
+    ~MappedFile() {
+#if defined(_WIN32)
+        if (data) {
+            UnmapViewOfFile(data);
+        }
+        if (mapping) {
+            CloseHandle(mapping);
+        }
+        if (file != INVALID_HANDLE_VALUE) {
+            CloseHandle(file);
+        }
+#else
+        if (data) {
+            munmap(const_cast<char*>(data), size);
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+#endif
+    }
+
+    /// `true` if the file could be opened and mapped. Empty files are not
+    /// mapped but have no data anyway.
+    bool good() const { return isOpen; }
+
+    std::string_view text() const {
+        return data ? std::string_view(data, size) : std::string_view();
+    }
+
+private:
+#if defined(_WIN32)
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#else
+    int fd = -1;
+#endif
+    char const* data = nullptr;
+    size_t size = 0;
+    bool isOpen = false;
+};
+
+/// \Returns the offset of the first of \p delimiter, `"`, `\n` or `\r` in
+/// \p text at or after \p pos , or `text.size()`
+size_t findSpecial(std::string_view text, size_t pos, char delimiter) {
+    char const* const data = text.data();
+    size_t const size = text.size();
+#if TFMT_CSV_SSE2
+    __m128i const delim = _mm_set1_epi8(delimiter);
+    __m128i const quote = _mm_set1_epi8('"');
+    __m128i const newline = _mm_set1_epi8('\n');
+    __m128i const carriageReturn = _mm_set1_epi8('\r');
+    for (; pos + 16 <= size; pos += 16) {
+        __m128i const block =
+            _mm_loadu_si128(reinterpret_cast<__m128i const*>(data + pos));
+        __m128i const matches =
+            _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, delim),
+                                      _mm_cmpeq_epi8(block, quote)),
+                         _mm_or_si128(_mm_cmpeq_epi8(block, newline),
+                                      _mm_cmpeq_epi8(block, carriageReturn)));
+        if (int const mask = _mm_movemask_epi8(matches)) {
+#if defined(_MSC_VER)
+            unsigned long index;
+            _BitScanForward(&index, static_cast<unsigned long>(mask));
+            return pos + index;
+#else
+            return pos + static_cast<size_t>(__builtin_ctz(
+                             static_cast<unsigned>(mask)));
+#endif
+        }
+    }
+#endif
+    for (; pos < size; ++pos) {
+        char const c = data[pos];
+        if (c == delimiter || c == '"' || c == '\n' || c == '\r') {
+            return pos;
+        }
+    }
+    return size;
+}
+
+/// Splits the mapped text into records of RFC 4180 fields
+/// \details Unquoted fields refer to the mapped text. Quoted fields that
+/// contain escaped quotes are unescaped into a scratch buffer that is reused
+/// for every record.
+class CSVReader {
+public:
+    explicit CSVReader(std::string_view text, char delimiter):
+        text(text), delimiter(delimiter) {}
+
+    /// Read the next record
+    /// \Returns `false` at the end of the input
+    bool next(std::vector<std::string_view>& fields) {
+        fields.clear();
+        if (pos >= text.size()) {
+            return false;
+        }
+        scratch.clear();
+        ranges.clear();
+        while (true) {
+            readField();
+            if (pos >= text.size()) {
+                break;
+            }
+            char const c = text[pos++];
+            if (c == delimiter) {
+                continue;
+            }
+            // Record separator, `\r\n` counts as one
+            if (c == '\r' && pos < text.size() && text[pos] == '\n') {
+                ++pos;
+            }
+            break;
+        }
+        // The scratch buffer does not move anymore, so we can create the
+        // views now
+        for (auto& range: ranges) {
+            fields.push_back(range.inScratch ?
+                                 std::string_view(scratch).substr(range.begin,
+                                                                  range.size) :
+                                 text.substr(range.begin, range.size));
+        }
+        return true;
+    }
+
+private:
+    struct FieldRange {
+        size_t begin;
+        size_t size;
+        bool inScratch;
+    };
+
+    void readField() {
+        if (pos < text.size() && text[pos] == '"') {
+            readQuotedField();
+            return;
+        }
+        size_t const begin = pos;
+        while (true) {
+            pos = findSpecial(text, pos, delimiter);
+            // Quotes inside unquoted fields are taken literally
+            if (pos < text.size() && text[pos] == '"') {
+                ++pos;
+                continue;
+            }
+            break;
+        }
+        ranges.push_back({ begin, pos - begin, false });
+    }
+
+    void readQuotedField() {
+        size_t begin = ++pos;
+        size_t const scratchBegin = scratch.size();
+        bool escaped = false;
+        while (true) {
+            size_t quote = text.find('"', pos);
+            if (quote == std::string_view::npos) {
+                // Unterminated field, take the rest of the input
+                quote = pos = text.size();
+            }
+            else if (quote + 1 < text.size() && text[quote + 1] == '"') {
+                // Keep one of the two quotes
+                scratch.append(text.substr(begin, quote + 1 - begin));
+                escaped = true;
+                pos = begin = quote + 2;
+                continue;
+            }
+            else {
+                pos = quote + 1;
+            }
+            if (escaped) {
+                scratch.append(text.substr(begin, quote - begin));
+                ranges.push_back(
+                    { scratchBegin, scratch.size() - scratchBegin, true });
+            }
+            else {
+                ranges.push_back({ begin, quote - begin, false });
+            }
+            break;
+        }
+        skipToSeparator();
+    }
+
+    /// Skips garbage between a closing quote and the next separator
+    void skipToSeparator() {
+        while (pos < text.size() && text[pos] != delimiter &&
+               text[pos] != '\n' && text[pos] != '\r')
+        {
+            ++pos;
+        }
+    }
+
+    std::string_view text;
+    char delimiter;
+    size_t pos = 0;
+    std::string scratch;
+    std::vector<FieldRange> ranges;
+};
+
+std::optional<double> parseNumber(std::string_view text) {
+    while (!text.empty() && text.front() == ' ') {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && text.back() == ' ') {
+        text.remove_suffix(1);
+    }
+    if (!text.empty() && text.front() == '+') {
+        text.remove_prefix(1);
+    }
+    double value;
+    auto const res =
+        std::from_chars(text.data(), text.data() + text.size(), value);
+    if (text.empty() || res.ec != std::errc{} ||
+        res.ptr != text.data() + text.size())
+    {
+        return std::nullopt;
+    }
+    return value;
+}
+
+/// Columns of which all non-empty sampled cells are numbers
+struct NumericColumn {
+    bool isNumeric = true;
+    bool hasValues = false;
+    std::vector<double> values;
+
+    /// Values at or above this are highlighted
+    double highlight = 0;
+};
+
+struct Options {
+    char const* path = nullptr;
+    char delimiter = 0;
+    size_t sampleSize = 1000;
+    bool header = true;
+};
+
+int usage() {
+    std::cerr << "Usage: tfmt-csv [-d <delimiter>] [-n <sample rows>] "
+                 "[--no-header] <file>\n";
+    return 2;
+}
+
+std::optional<Options> parseArgs(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view const arg = argv[i];
+        if (arg == "-d" && i + 1 < argc) {
+            std::string_view const delim = argv[++i];
+            if (delim == "\\t") {
+                options.delimiter = '\t';
+            }
+            else if (delim.size() == 1) {
+                options.delimiter = delim.front();
+            }
+            else {
+                return std::nullopt;
+            }
+        }
+        else if (arg == "-n" && i + 1 < argc) {
+            std::string_view const count = argv[++i];
+            auto const res = std::from_chars(count.data(),
+                                             count.data() + count.size(),
+                                             options.sampleSize);
+            if (count.empty() || res.ec != std::errc{} ||
+                res.ptr != count.data() + count.size())
+            {
+                return std::nullopt;
+            }
+            options.sampleSize = std::max<size_t>(1, options.sampleSize);
+        }
+        else if (arg == "--no-header") {
+            options.header = false;
+        }
+        else if (!options.path && !arg.starts_with("-")) {
+            options.path = argv[i];
+        }
+        else {
+            return std::nullopt;
+        }
+    }
+    if (!options.path) {
+        return std::nullopt;
+    }
+    if (!options.delimiter) {
+        options.delimiter =
+            std::string_view(options.path).ends_with(".tsv") ? '\t' : ',';
+    }
+    return options;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    auto const options = parseArgs(argc, argv);
+    if (!options) {
+        return usage();
+    }
+    MappedFile file(options->path);
+    if (!file.good()) {
+        std::cerr << "tfmt-csv: Cannot open " << options->path << ": "
+                  << std::strerror(errno) << "\n";
+        return 1;
+    }
+    CSVReader reader(file.text(), options->delimiter);
+    std::vector<std::string_view> fields;
+    std::vector<std::string> header;
+    if (options->header && reader.next(fields)) {
+        header.assign(fields.begin(), fields.end());
+    }
+    // Read the sample window to infer the numeric columns
+    std::vector<std::vector<std::string>> sample;
+    std::vector<NumericColumn> columns(header.size());
+    while (sample.size() < options->sampleSize && reader.next(fields)) {
+        sample.emplace_back(fields.begin(), fields.end());
+        if (columns.size() < fields.size()) {
+            columns.resize(fields.size());
+        }
+        for (size_t i = 0; i < fields.size(); ++i) {
+            if (fields[i].empty() || !columns[i].isNumeric) {
+                continue;
+            }
+            if (auto value = parseNumber(fields[i])) {
+                columns[i].values.push_back(*value);
+                columns[i].hasValues = true;
+            }
+            else {
+                columns[i].isNumeric = false;
+                columns[i].values = {};
+            }
+        }
+    }
+    tfmt::TableOptions tableOptions;
+    tableOptions.sampleSize = sample.size() + 1;
+    tableOptions.headerModifier = &tfmt::Bold;
+    if (auto width = tfmt::getWidth(std::cout)) {
+        // Fit the table to the terminal, so that rows don't wrap. The widest
+        // columns are cut first, which are rarely the numeric ones.
+        tableOptions.maxTableWidth = *width;
+    }
+    else {
+        // Truncated numbers would be misleading
+        tableOptions.overflow = tfmt::TableOverflow::Expand;
+    }
+    for (auto& column: columns) {
+        column.isNumeric &= column.hasValues;
+        tableOptions.alignment.push_back(column.isNumeric ?
+                                             tfmt::TableAlign::Right :
+                                             tfmt::TableAlign::Left);
+        if (column.isNumeric) {
+            // Highlight the top decile of the sample
+            auto& values = column.values;
+            auto nth = values.begin() + values.size() * 9 / 10;
+            std::nth_element(values.begin(), nth, values.end());
+            column.highlight = *nth;
+            values = {};
+        }
+    }
+    bool const styled = tfmt::isTermFormattable(std::cout);
+    tfmt::TableWriter table(std::cout, std::move(header), tableOptions);
+    std::vector<std::string> styledCells(columns.size());
+    std::vector<std::string_view> cells;
+    auto numberModifier = [&](size_t column,
+                              double value) -> tfmt::Modifier const& {
+        if (value < 0) {
+            return tfmt::Red;
+        }
+        return value >= columns[column].highlight ? tfmt::BrightYellow :
+                                                    tfmt::Cyan;
+    };
+    auto putRow = [&](auto const& row) {
+        cells.assign(row.begin(), row.end());
+        size_t const numCells = std::min(cells.size(), columns.size());
+        for (size_t i = 0; i < numCells; ++i) {
+            if (cells[i].find_first_of("\r\n") != std::string_view::npos) {
+                // Line breaks in quoted fields would break the table
+                auto& buffer = styledCells[i];
+                buffer.assign(cells[i]);
+                std::replace(buffer.begin(), buffer.end(), '\n', ' ');
+                std::replace(buffer.begin(), buffer.end(), '\r', ' ');
+                cells[i] = buffer;
+                continue;
+            }
+            if (!styled || !columns[i].isNumeric) {
+                continue;
+            }
+            auto value = parseNumber(cells[i]);
+            if (!value) {
+                continue;
+            }
+            auto const& mod = numberModifier(i, *value);
+            auto& buffer = styledCells[i];
+            buffer.assign(mod.ansiBuffer());
+            buffer += cells[i];
+            buffer += mod.ansiOffBuffer();
+            cells[i] = buffer;
+        }
+        table.addRow(cells);
+    };
+    for (auto& row: sample) {
+        putRow(row);
+    }
+    sample = {};
+    table.finish();
+    while (reader.next(fields)) {
+        putRow(fields);
+    }
+}
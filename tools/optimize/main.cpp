@@ -0,0 +1,114 @@
+// tfmt-optimize: Rewrite ANSI colored text with minimal SGR sequences
+//
+// Usage: tfmt-optimize [--stats] [<file>...]
+//
+// Reads the files or standard input and writes the optimized text to standard
+// output. With --stats the byte savings are reported on standard error.
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <termfmt/optimize.h>
+
+namespace {
+
+struct Options {
+    std::vector<char const*> paths;
+    bool stats = false;
+};
+
+int usage() {
+    std::cerr << "Usage: tfmt-optimize [--stats] [<file>...]\n";
+    return 2;
+}
+
+std::optional<Options> parseArgs(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view const arg = argv[i];
+        if (arg == "--stats") {
+            options.stats = true;
+        }
+        else if (arg == "-" || !arg.starts_with("-")) {
+            options.paths.push_back(argv[i]);
+        }
+        else {
+            return std::nullopt;
+        }
+    }
+    if (options.paths.empty()) {
+        options.paths.push_back("-");
+    }
+    return options;
+}
+
+/// Optimize the contents of \p file and write them to standard output
+/// \Returns `false` on read or write errors
+bool optimizeFile(std::FILE* file,
+                  tfmt::SGROptimizer& optimizer,
+                  std::string& out) {
+    static char buffer[1 << 16];
+    while (std::size_t const size =
+               std::fread(buffer, 1, sizeof buffer, file))
+    {
+        out.clear();
+        optimizer.optimize(std::string_view(buffer, size), out);
+        if (std::fwrite(out.data(), 1, out.size(), stdout) != out.size()) {
+            return false;
+        }
+    }
+    return !std::ferror(file);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    auto const options = parseArgs(argc, argv);
+    if (!options) {
+        return usage();
+    }
+    // The style carries over from one file to the next, as with `cat`
+    tfmt::SGROptimizer optimizer;
+    std::string out;
+    int status = 0;
+    for (char const* path: options->paths) {
+        bool const isStdin = std::string_view(path) == "-";
+        std::FILE* file = isStdin ? stdin : std::fopen(path, "rb");
+        if (!file) {
+            std::cerr << "tfmt-optimize: Cannot open " << path << ": "
+                      << std::strerror(errno) << "\n";
+            status = 1;
+            continue;
+        }
+        if (!optimizeFile(file, optimizer, out)) {
+            std::cerr << "tfmt-optimize: Error processing " << path << ": "
+                      << std::strerror(errno) << "\n";
+            status = 1;
+        }
+        if (!isStdin) {
+            std::fclose(file);
+        }
+    }
+    out.clear();
+    optimizer.finish(out);
+    std::fwrite(out.data(), 1, out.size(), stdout);
+    std::fflush(stdout);
+    if (options->stats) {
+        auto const in = optimizer.bytesIn();
+        auto const saved = in - optimizer.bytesOut();
+        std::cerr << "tfmt-optimize: " << in << " bytes in, "
+                  << optimizer.bytesOut() << " bytes out, " << saved
+                  << " bytes saved ("
+                  << (in ? 100.0 * static_cast<double>(saved) /
+                               static_cast<double>(in) :
+                           0.0)
+                  << "%)\n";
+    }
+    return status;
+}